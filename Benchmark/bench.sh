@@ -0,0 +1,98 @@
+#!/bin/sh
+# Gera uma carga de trabalho, mede cada etapa da montagem e da ligação e
+# acrescenta o resultado em resultados.csv (um histórico das medições).
+#
+# Modo de uso: ./bench.sh [opções do gerador]
+
+cd "$(dirname "$0")" || exit 1
+
+MONTADOR=../Montador/montador
+LIGADOR=../Ligador/ligador
+CARGA=./carga
+WORK=work
+RESULTS=resultados.csv
+
+rm -rf $WORK
+mkdir -p $WORK
+
+now() {
+  date +%s%N
+}
+
+# Soma o wall_ms de uma etapa nos arquivos --stats dados: phase_ms etapa arquivos
+phase_ms() {
+  phase=$1
+  shift
+  cat "$@" | awk -v phase="$phase" '
+    index($0, "{\"name\": \"" phase "\"") {
+      split($0, fields, "\"wall_ms\": ")
+      split(fields[2], value, ",")
+      total += value[1]
+    }
+    END { printf "%.2f", total }'
+}
+
+# Tempo de um formato na saída do carga: load_ms rótulo
+load_ms() {
+  echo "$load" | awk -v label="$1" 'index($0, label) == 1 { print $(NF - 1) }'
+}
+
+# Geração
+modules=$(./gerador "$@" $WORK/bench) || { echo "$modules"; exit 1; }
+
+# Montagem de cada módulo
+start=$(now)
+for module in $modules; do
+  $MONTADOR --stats "$module" > /dev/null || { echo "Erro ao montar $module"; exit 1; }
+done
+assemble_ms=$(( ($(now) - start) / 1000000 ))
+
+# Ligação (inclui a leitura dos .obj)
+start=$(now)
+$LIGADOR --stats $modules > /dev/null || { echo "Erro ao ligar"; exit 1; }
+link_ms=$(( ($(now) - start) / 1000000 ))
+
+# Carga do executável em texto (.e), comprimido (.ez) e binário (.eb)
+$LIGADOR --compress $modules > /dev/null || { echo "Erro ao ligar"; exit 1; }
+$LIGADOR --binary $modules > /dev/null || { echo "Erro ao ligar"; exit 1; }
+load=$($CARGA $WORK/bench_0) || { echo "$load"; exit 1; }
+
+asm_bytes=$(cat $WORK/*.asm | wc -c)
+obj_bytes=$(cat $WORK/*.obj | wc -c)
+exe_bytes=$(wc -c < $WORK/bench_0.e)
+ez_bytes=$(wc -c < $WORK/bench_0.ez)
+commit=$(git rev-parse --short HEAD 2>/dev/null || echo "-")
+
+# Etapas de cada ferramenta (somadas em todos os módulos, no montador)
+stats=""
+for module in $modules; do
+  stats="$stats $module.stats.json"
+done
+pre_ms=$(phase_ms pre-processing $stats)
+pass1_ms=$(phase_ms pass1 $stats)
+pass2_ms=$(phase_ms pass2 $stats)
+output_ms=$(phase_ms output $stats)
+parse_ms=$(phase_ms parse $WORK/bench_0.e.stats.json)
+resolve_ms=$(phase_ms resolve $WORK/bench_0.e.stats.json)
+write_ms=$(phase_ms write $WORK/bench_0.e.stats.json)
+
+echo "Parâmetros:   $*"
+echo "Fonte:        $asm_bytes bytes"
+echo "Montagem:     $assemble_ms ms"
+echo "Ligação:      $link_ms ms"
+echo "Objetos:      $obj_bytes bytes"
+echo "Executável:   $exe_bytes bytes"
+echo "Comprimido:   $ez_bytes bytes"
+echo "$load"
+echo "Montador:     pré-processamento $pre_ms ms, passagem 1 $pass1_ms ms, passagem 2 $pass2_ms ms, saída $output_ms ms"
+echo "Ligador:      leitura $parse_ms ms, resolução $resolve_ms ms, escrita $write_ms ms"
+
+# Um histórico com outras colunas é guardado à parte e um novo é começado
+header="data,commit,parametros,fonte_bytes,montagem_ms,pre_ms,passagem1_ms,passagem2_ms,saida_ms,ligacao_ms,leitura_ms,resolucao_ms,escrita_ms,obj_bytes,e_bytes,ez_bytes,carga_e_ms,carga_ez_ms,mapeamento_eb_ms"
+if [ -f $RESULTS ] && [ "$(head -n 1 $RESULTS)" != "$header" ]; then
+  mv $RESULTS "resultados-$(date +%Y%m%d%H%M%S).csv"
+fi
+if [ ! -f $RESULTS ]; then
+  echo "$header" > $RESULTS
+fi
+echo "$(date +%Y-%m-%dT%H:%M:%S),$commit,$*,$asm_bytes,$assemble_ms,$pre_ms,$pass1_ms,$pass2_ms,$output_ms,$link_ms,$parse_ms,$resolve_ms,$write_ms,$obj_bytes,$exe_bytes,$ez_bytes,$(load_ms "Carga .e:"),$(load_ms "Carga .ez:"),$(load_ms "Mapeamento .eb:")" >> $RESULTS
@@ -0,0 +1,43 @@
+#ifndef GERADOR_HPP_
+#define GERADOR_HPP_
+
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Workload parameters (see the usage message in Gerador.cpp)
+typedef struct {
+  int labels = 1000;        // Text labels per module
+  int data_labels = 0;      // Data labels per module (0: labels / 10 + 1)
+  int modules = 4;
+  double equ_density = 0.05; // EQU directives per text label
+  double if_density = 0.05;  // Probability of an IF before an instruction
+  double space_ratio = 0.5;  // Fraction of the data labels that are SPACE
+  int fan_out = 4;           // PUBLIC labels (and EXTERN uses) per module
+  unsigned int seed = 1;
+  string prefix;
+} Parametros;
+
+class Gerador
+{
+private:
+  Parametros params;
+  mt19937 rng;
+  int random(int limit);
+  bool chance(double probability);
+  int spaces();
+  int constants();
+  string space(int module, int i);
+  string constant(int module, int i);
+  string textLabel(int module, int i);
+  void writeInstruction(fstream& file, int module, vector<string>& externs);
+public:
+  Gerador(Parametros t_params);
+  ~Gerador();
+  string writeModule(int module);
+};
+
+#endif /* GERADOR_HPP_ */
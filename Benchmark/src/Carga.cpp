@@ -0,0 +1,104 @@
+// Software básico - Medição da carga de executáveis (.e, .ez e .eb)
+
+// Includes:
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "Imagem.hpp"
+
+// Namespace:
+using namespace std;
+
+// Function headers
+double loadTime(string name, int repetitions, vector<uint16_t>& code);
+double mapTime(string name, int repetitions, vector<uint16_t>& code);
+
+// Main function: loads nome.e and nome.ez several times, as a simulator
+// would (opening the file and decoding it into memory), and prints the
+// size and the mean load time of each format. If there is a nome.eb, also
+// the time to map it.
+int main(int argc, char const *argv[])
+{
+  vector<uint16_t> text_code, compressed_code, binary_code;
+  int repetitions = 20;
+  double text_ms, compressed_ms, binary_ms = -1;
+  fstream binary_file;
+
+  if(argc < 2 || argc > 3 || (argc == 3 && (repetitions = atoi(argv[2])) < 1)) {
+    cout << "Modo de uso: carga nome_do_executavel_sem_e [repetições]" << endl;
+    exit(1);
+  }
+
+  text_ms = loadTime(string(argv[1]) + ".e", repetitions, text_code);
+  compressed_ms = loadTime(string(argv[1]) + ".ez", repetitions, compressed_code);
+
+  binary_file.open(string(argv[1]) + ".eb", ios::in);
+  if(binary_file.is_open()) {
+    binary_file.close();
+    binary_ms = mapTime(string(argv[1]) + ".eb", repetitions, binary_code);
+  } else {
+    binary_code = text_code;
+  }
+
+  if(text_code != compressed_code || text_code != binary_code) {
+    cout << "Erro: os formatos de " << argv[1] << " são diferentes" << endl;
+    exit(3);
+  }
+
+  cout << "Palavras:     " << text_code.size() << endl;
+  cout << "Carga .e:     " << text_ms << " ms" << endl;
+  cout << "Carga .ez:    " << compressed_ms << " ms" << endl;
+  if(binary_ms >= 0) {
+    cout << "Mapeamento .eb: " << binary_ms << " ms" << endl;
+  }
+
+  return 0;
+}
+
+// Mean time, in ms, to open and load the image. The last load is kept in code.
+double loadTime(string name, int repetitions, vector<uint16_t>& code)
+{
+  fstream file;
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+  for(int i = 0; i < repetitions; i++) {
+    file.open(name, ios::in | ios::binary);
+    if(!file.is_open()) {
+      cout << "Erro: arquivo " << name << " não existe!" << endl;
+      exit(2);
+    }
+    if(!loadImage(file, code)) {
+      cout << "Erro: arquivo " << name << " corrompido" << endl;
+      exit(3);
+    }
+    file.close();
+  }
+
+  return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count() / repetitions;
+}
+
+// Mean time, in ms, to map the binary image, ready to be used in place. The
+// words of the last mapping are copied to code (not measured).
+double mapTime(string name, int repetitions, vector<uint16_t>& code)
+{
+  ImagemMapeada image;
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  double total;
+
+  for(int i = 0; i < repetitions; i++) {
+    if(!image.open(name)) {
+      cout << "Erro: arquivo " << name << " corrompido" << endl;
+      exit(3);
+    }
+    if(i + 1 < repetitions) {
+      image.close();
+    }
+  }
+  total = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+  code.assign(image.getWords(), image.getWords() + image.getSize());
+  return total / repetitions;
+}
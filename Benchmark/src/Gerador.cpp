@@ -0,0 +1,229 @@
+// Software básico - Gerador de cargas de trabalho para o montador e o ligador
+
+// Includes:
+#include <iostream>
+#include <string>
+#include "Gerador.hpp"
+
+// Namespace:
+using namespace std;
+
+// Main function:
+int main(int argc, char const *argv[])
+{
+  Parametros params;
+  string arg;
+
+  for(int i = 1; i < argc; i++) {
+    arg = argv[i];
+    if(arg[0] == '-' && arg.size() == 2 && i + 1 < argc) {
+      switch(arg[1]) {
+      case 'n': params.labels = stoi(argv[++i]); break;
+      case 'd': params.data_labels = stoi(argv[++i]); break;
+      case 'm': params.modules = stoi(argv[++i]); break;
+      case 'e': params.equ_density = stod(argv[++i]); break;
+      case 'i': params.if_density = stod(argv[++i]); break;
+      case 's': params.space_ratio = stod(argv[++i]); break;
+      case 'f': params.fan_out = stoi(argv[++i]); break;
+      case 'r': params.seed = stoul(argv[++i]); break;
+      default:
+        cout << "Erro: opção desconhecida " << arg << endl;
+        exit(1);
+      }
+    } else if(params.prefix == "" && arg[0] != '-') {
+      params.prefix = arg;
+    } else {
+      params.prefix = "";
+      break;
+    }
+  }
+
+  if(params.prefix == "" || params.labels < 1 || params.modules < 1) {
+    cout << "Modo de uso: gerador [opções] prefixo" << endl;
+    cout << "  -n rótulos   rótulos de código por módulo (1000)" << endl;
+    cout << "  -d rótulos   rótulos de dados por módulo (n/10 + 1)" << endl;
+    cout << "  -m módulos   quantidade de módulos (4)" << endl;
+    cout << "  -e densidade diretivas EQU por rótulo de código (0.05)" << endl;
+    cout << "  -i densidade chance de um IF antes de cada instrução (0.05)" << endl;
+    cout << "  -s razão     fração dos rótulos de dados que são SPACE (0.5)" << endl;
+    cout << "  -f fan-out   rótulos PUBLIC e usos EXTERN por módulo (4)" << endl;
+    cout << "  -r semente   semente do gerador aleatório (1)" << endl;
+    exit(1);
+  }
+  if(params.data_labels < 1) {
+    params.data_labels = params.labels / 10 + 1;
+  }
+
+  Gerador generator(params);
+  for(int i = 0; i < params.modules; i++) {
+    cout << generator.writeModule(i) << endl;
+  }
+
+  return 0;
+}
+
+Gerador::Gerador(Parametros t_params)
+{
+  params = t_params;
+}
+
+Gerador::~Gerador()
+{
+}
+
+// Writes prefix_<module>.asm and returns its name without the extension.
+// Module 0 is the entry point; every module is a BEGIN/END module so the
+// whole program can be linked.
+string Gerador::writeModule(int module)
+{
+  string name = params.prefix + "_" + to_string(module);
+  fstream file;
+  vector<string> externs;
+  int equs, other;
+
+  // Each module gets its own stream, so modules don't depend on each other
+  rng.seed(params.seed * 7919 + module);
+
+  file.open(name + ".asm", ios::out);
+  if(!file.is_open()) {
+    cout << "Erro: não é possível criar arquivo de saída " << name << ".asm" << endl;
+    exit(4);
+  }
+
+  file << "M" << module << ": BEGIN\n";
+
+  // Aliases: E<i>_1 and E<i>_0 feed the IF directives, E<i> the constants
+  equs = (int) (params.equ_density * params.labels) + 1;
+  for(int i = 0; i < equs; i++) {
+    file << "E" << i << "_1: EQU 1\n";
+    file << "E" << i << "_0: EQU 0\n";
+    file << "E" << i << ": EQU " << (random(100) + 1) << "\n";
+  }
+
+  file << "SECTION TEXT\n";
+
+  // Uses of the public labels of other modules
+  if(params.modules > 1) {
+    for(int i = 0; i < params.fan_out; i++) {
+      other = (module + 1 + random(params.modules - 1)) % params.modules;
+      string label = textLabel(other, random(min(params.fan_out, params.labels)));
+      bool repeated = false;
+      for(auto const& item : externs) {
+        repeated = repeated || item == label;
+      }
+      if(!repeated) {
+        externs.push_back(label);
+        file << label << ": EXTERN\n";
+      }
+    }
+  }
+  for(int i = 0; i < params.fan_out && i < params.labels; i++) {
+    file << "PUBLIC " << textLabel(module, i) << "\n";
+  }
+
+  // Each text label starts a block of four instructions
+  for(int i = 0; i < params.labels; i++) {
+    file << textLabel(module, i) << ": ";
+    writeInstruction(file, module, externs);
+    for(int j = 0; j < 3; j++) {
+      if(chance(params.if_density)) {
+        int alias = random(equs);
+        file << "IF E" << alias << (chance(0.5) ? "_1" : "_0") << "\n";
+      }
+      writeInstruction(file, module, externs);
+    }
+  }
+  file << "STOP\n";
+
+  file << "SECTION DATA\n";
+  for(int i = 0; i < constants(); i++) {
+    file << constant(module, i) << ": CONST ";
+    if(chance(0.5))
+      file << "E" << random(equs) << "\n";
+    else
+      file << (random(1000) + 1) << "\n";
+  }
+
+  file << "SECTION BSS\n";
+  for(int i = 0; i < spaces(); i++) {
+    file << space(module, i) << ": SPACE";
+    if(i % 4 == 0)
+      file << " 4";
+    file << "\n";
+  }
+
+  file << "END\n";
+  file.close();
+
+  return name;
+}
+
+// Writes one instruction whose operands are valid for the assembler:
+// stores go to SPACE labels, jumps go to text labels and DIV never uses 0.
+void Gerador::writeInstruction(fstream& file, int module, vector<string>& externs)
+{
+  static const char *arithmetic[] = {"ADD", "SUB", "MULT", "DIV", "LOAD", "OUTPUT"};
+  static const char *jumps[] = {"JMP", "JMPN", "JMPP", "JMPZ"};
+  int kind = random(10);
+
+  if(kind < 4) {
+    file << arithmetic[random(6)] << " ";
+    if(chance(0.5))
+      file << constant(module, random(params.data_labels));
+    else
+      file << space(module, random(params.data_labels));
+  }
+  else if(kind < 6) {
+    file << (chance(0.5) ? "STORE " : "INPUT ") << space(module, random(params.data_labels));
+  }
+  else if(kind < 7) {
+    file << "COPY " << constant(module, random(params.data_labels)) << ", "
+         << space(module, random(params.data_labels));
+  }
+  else if(kind < 9 || externs.empty()) {
+    file << jumps[random(4)] << " " << textLabel(module, random(params.labels));
+  }
+  else {
+    file << jumps[random(4)] << " " << externs[random(externs.size())];
+  }
+  file << "\n";
+}
+
+// Auxiliary methods
+
+int Gerador::random(int limit)
+{
+  return uniform_int_distribution<int>(0, limit - 1)(rng);
+}
+
+bool Gerador::chance(double probability)
+{
+  return uniform_real_distribution<double>(0.0, 1.0)(rng) < probability;
+}
+
+// Data labels are split between SPACE and CONST by space_ratio, with at
+// least one of each so every instruction always has a valid operand.
+int Gerador::spaces()
+{
+  return max(1, (int) (params.data_labels * params.space_ratio + 0.5));
+}
+
+int Gerador::constants()
+{
+  return max(1, params.data_labels - spaces());
+}
+
+string Gerador::space(int module, int i)
+{
+  return "M" + to_string(module) + "_S" + to_string(i % spaces());
+}
+
+string Gerador::constant(int module, int i)
+{
+  return "M" + to_string(module) + "_C" + to_string(i % constants());
+}
+
+string Gerador::textLabel(int module, int i)
+{
+  return "M" + to_string(module) + "_L" + to_string(i);
+}
@@ -0,0 +1,37 @@
+#ifndef BIBLIOTECA_HPP_
+#define BIBLIOTECA_HPP_
+
+#include <map>
+#include <fstream>
+#include <vector>
+#include "Modulo.hpp"
+
+using namespace std;
+
+// Place of a member in the library: its .obj and then its .map, if any
+typedef struct {
+  long offset;
+  long size;
+  long map_size; // 0 when the member has no debug map
+} LibraryMember;
+
+// Library of .obj modules (.lib file) with a global symbol index. Only the
+// index is read when the library is opened; members are parsed on demand.
+class Biblioteca
+{
+private:
+  string lib_name;
+  fstream lib_file;
+  map<string, string> index; // Public label -> member that defines it
+  map<string, LibraryMember> members;
+  streampos data_start;
+  void readIndex();
+public:
+  Biblioteca(string t_lib_name);
+  ~Biblioteca();
+  string findMember(string label);
+  Modulo* extract(string member);
+  static void create(string t_lib_name, vector<string> obj_names);
+};
+
+#endif /* BIBLIOTECA_HPP_ */
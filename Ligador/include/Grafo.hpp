@@ -0,0 +1,42 @@
+#ifndef GRAFO_HPP_
+#define GRAFO_HPP_
+
+#include <map>
+#include <ostream>
+#include <set>
+#include <vector>
+
+using namespace std;
+
+// Basic block: instructions in [start, end) that always run in sequence
+typedef struct {
+  int start;
+  int end;
+  vector<int> successors; // Start address of each successor block
+} BasicBlock;
+
+class Grafo
+{
+private:
+  vector<int> code;
+  set<int> relative; // Operand positions (relative words, uses of labels)
+  set<int> external; // Operands that point to other modules
+  set<int> instructions; // Start address of every reachable instruction
+  set<int> leaders;
+  map<int, BasicBlock> blocks;
+  vector<bool> code_mask; // true for words that belong to an instruction
+  int instructionSize(int opcode);
+  bool decodable(int address);
+public:
+  Grafo(vector<int> t_code, vector<int> t_relative, vector<int> t_external);
+  ~Grafo();
+  void build(vector<int> roots);
+  // Getters
+  map<int, BasicBlock> getBlocks();
+  bool isCode(int address);
+  vector<int> getDataAddresses();
+  vector<int> getUnreachableAddresses();
+  void write(ostream& output);
+};
+
+#endif /* GRAFO_HPP_ */
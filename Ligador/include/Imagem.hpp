@@ -0,0 +1,57 @@
+#ifndef IMAGEM_HPP_
+#define IMAGEM_HPP_
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Executable image (the linked code) in its formats: text (.e), one decimal
+// per word, compressed (.ez), a binary LZ stream of the words, and binary
+// (.eb), the words as they are in memory.
+//
+// Compressed format: "SBEZ", the number of words and a sequence of blocks,
+// every number as a varint (7 bits per byte, low bits first, high bit set
+// when more bytes follow). A block starts with a header h. If h is even,
+// h / 2 literal words follow. If h is odd, the distance d follows and the
+// h / 2 + 3 next words repeat the ones starting d words back (they may
+// overlap the words being written, which makes runs of zeros cheap).
+//
+// In the text, the words marked in addresses are written unsigned and the
+// others as signed 16-bit numbers (CONST -5 is -5), as the montador does.
+
+void writeTextImage(ostream& output, const vector<uint16_t>& code,
+                    const vector<bool>& addresses);
+void writeCompressedImage(ostream& output, const vector<uint16_t>& code);
+bool loadImage(istream& input, vector<uint16_t>& code);
+
+// Binary format: "SBEB", the number of words (4 bytes) and the words, 2
+// bytes each, all little endian. The words start 8 bytes into the file, so
+// the image can be mapped and used in place.
+void writeBinaryImage(ostream& output, const vector<uint16_t>& code);
+
+// Binary image mapped privately (copy on write): the words are read and
+// changed in place, without parsing or copying, and the file is never
+// written. Processes that map the same image share the pages they don't
+// change. Only on little endian hosts.
+class ImagemMapeada
+{
+private:
+  void* mapping;
+  size_t mapping_size;
+  uint16_t* words;
+  size_t word_count;
+public:
+  ImagemMapeada();
+  ImagemMapeada(const ImagemMapeada&) = delete;
+  ~ImagemMapeada();
+  bool open(string name);
+  void close();
+  uint16_t* getWords();
+  size_t getSize();
+};
+
+#endif /* IMAGEM_HPP_ */
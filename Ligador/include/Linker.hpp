@@ -0,0 +1,31 @@
+#ifndef LINKER_HPP_
+#define LINKER_HPP_
+
+#include <map>
+#include <ostream>
+#include <vector>
+#include "Modulo.hpp"
+
+using namespace std;
+
+// Links the parsed modules in memory: the functions below only read and
+// write the modules and streams given to them, never files.
+
+// Places each module after the previous ones, fixes the uses of the labels
+// they define and relocates them. Fills the correction table (start of each
+// module) and the global definitions table; returns the linked code. A
+// module that ends past the 16-bit memory (65536 words) or whose relocated
+// addresses don't fit in 16 bits gets an error (see Modulo::getErrorCode).
+vector<uint16_t> linkModules(vector<Modulo*> objs, vector<int>& correction_table,
+                             map<string, int>& gdt);
+vector<uint16_t> concatenateCodes(vector<Modulo*> objs);
+// Which words of the linked code are addresses (relocated, or uses of
+// labels). The .e and .obj texts write them unsigned and the other words
+// as signed 16-bit numbers.
+vector<bool> findAddressWords(vector<Modulo*> objs, vector<int> correction_table);
+vector<Modulo*> removeUnusedModules(vector<Modulo*> objs);
+void writeDebugMap(ostream& output, vector<Modulo*> objs);
+void writePartialObject(ostream& output, vector<Modulo*> objs,
+                        vector<int> correction_table, map<string, int> gdt);
+
+#endif /* LINKER_HPP_ */
@@ -1,42 +1,72 @@
 #ifndef MODULO_HPP_
 #define MODULO_HPP_
 
+#include <cstdint>
 #include <map>
 #include <fstream>
 #include <vector>
 
 using namespace std;
 
+// Entry of a module's debug map (address -> source line and label)
+typedef struct {
+  int address;
+  string module; // Module of the source line
+  int line;
+  string label;
+} DebugEntry;
+
+// Code words and addresses are 16 bits wide (negative constants in two's
+// complement), as in the machine.
 class Modulo
 {
 private:
   string obj_name;
   fstream obj_file;
-  map<string, vector<int>> use_table;
+  map<string, vector<uint16_t>> use_table;
   map<string, int> definitions_table;
-  vector<int> relative;
-  vector<int> code;
-  vector<int> splitStringToInts(string phrase);
+  vector<uint16_t> relative;
+  vector<uint16_t> code;
+  bool splitStringToWords(string phrase, vector<uint16_t>& words);
+  void accumulateDeltas(vector<uint16_t>& addresses);
   //vector<unsigned char> splitStringToUChars(string phrase);
-  vector<int> corrected; // Stores addresses that were corrected
+  vector<uint16_t> corrected; // Stores addresses that were corrected
+  vector<DebugEntry> debug_map; // Read from the optional .map file
+  bool has_debug_map;
+  long bytes_read;
+  int error_code; // 0, or the exit code of the ligador for the error
+  string error_message;
 public:
   Modulo(string t_obj_name);
+  Modulo(string t_obj_name, istream& source);
+  Modulo(string t_obj_name, map<string, vector<uint16_t>> t_use_table,
+         map<string, int> t_definitions_table, vector<uint16_t> t_relative,
+         vector<uint16_t> t_code, vector<DebugEntry> t_debug_map);
   ~Modulo();
   void openStream();
   void parse();
+  void parse(istream& source);
+  void parseDebugMap();
+  void parseDebugMap(istream& source);
   void fixCrossReferences(map<string, int> gdt);
   void fixRelativeAddresses(int correction_table);
   // Getters
-  map<string, vector<int>> getUseTable();
+  map<string, vector<uint16_t>> getUseTable();
   map<string, int> getDefinitionsTable();
-  vector<int> getRelativeAddresses();
-  vector<int> getCode();
+  vector<uint16_t> getRelativeAddresses();
+  vector<uint16_t> getCode();
   int getCodeSize();
+  string getName();
+  vector<DebugEntry> getDebugMap();
+  bool hasDebugMap();
+  long getBytesRead();
+  int getErrorCode();
+  string getErrorMessage();
   // Debug
   void printAllData();
   void printTable(map<string, int> table);
-  void printUseTable(map<string, vector<int>> table);
-  void printVectorInt(vector<int> items);
+  void printUseTable(map<string, vector<uint16_t>> table);
+  void printVectorInt(vector<uint16_t> items);
   //void printVectorUChar(vector<unsigned char> items);
 };
 
@@ -0,0 +1,179 @@
+#include "Biblioteca.hpp"
+#include <iostream>
+#include <regex>
+#include <sstream>
+
+typedef enum {
+  NONE,
+  INDEX,
+  MEMBERS
+} Section;
+
+using namespace std;
+
+Biblioteca::Biblioteca(string t_lib_name)
+{
+  lib_name = t_lib_name;
+  lib_file.open(lib_name + ".lib", ios::in | ios::binary);
+  if (!lib_file.is_open()) {
+    cout << "Erro: arquivo " << lib_name << ".lib não existe!" << endl;
+    exit(2);
+  }
+  this->readIndex();
+}
+
+Biblioteca::~Biblioteca()
+{
+  if(lib_file.is_open()){
+    lib_file.close();
+  }
+}
+
+// Reads the header: the symbol index and the table of members (name,
+// offset, size of the .obj and size of the .map, which older libraries don't
+// have). The members themselves are stored right after the header, in the
+// same order, each .obj followed by its .map.
+void Biblioteca::readIndex()
+{
+  string file_line;
+  smatch search_matches;
+  Section section = NONE;
+
+  static const regex index_regex("^([A-Za-z_][A-Za-z_\\d]*) (\\S+)$");
+  static const regex member_regex("^(\\S+) (\\d+) (\\d+)(?: (\\d+))?$");
+
+  getline(lib_file, file_line);
+  if(file_line != "LIBRARY") {
+    cout << "Erro: arquivo " << lib_name << ".lib não é uma biblioteca" << endl;
+    exit(3);
+  }
+
+  while(getline(lib_file, file_line)) {
+    if(file_line == "INDEX") {
+      section = INDEX;
+    }
+    else if(file_line == "MEMBERS") {
+      section = MEMBERS;
+    }
+    else if(file_line == "") {
+      // The blank line after the table of members ends the header
+      if(section == MEMBERS) {
+        break;
+      }
+      section = NONE;
+    }
+    else if(section == INDEX && regex_search(file_line, search_matches, index_regex)) {
+      index[search_matches[1].str()] = search_matches[2].str();
+    }
+    else if(section == MEMBERS && regex_search(file_line, search_matches, member_regex)) {
+      members[search_matches[1].str()] = {stol(search_matches[2].str()),
+                                          stol(search_matches[3].str()),
+                                          search_matches[4].matched ?
+                                          stol(search_matches[4].str()) : 0};
+    }
+    else {
+      cout << "Erro: arquivo " << lib_name << ".lib corrompido" << endl;
+      exit(3);
+    }
+  }
+  data_start = lib_file.tellg();
+}
+
+// Returns the member that defines the label, or "" if there is none
+string Biblioteca::findMember(string label)
+{
+  if(index.count(label) == 0) {
+    return "";
+  }
+  return index[label];
+}
+
+// Reads and parses a single member, with its debug map
+Modulo* Biblioteca::extract(string member)
+{
+  string contents;
+  Modulo* obj;
+
+  if(members.count(member) == 0) {
+    cout << "Erro: membro " << member << " não existe em " << lib_name << ".lib" << endl;
+    exit(3);
+  }
+
+  contents.resize(members[member].size + members[member].map_size);
+  lib_file.clear();
+  lib_file.seekg(data_start + (streamoff) members[member].offset);
+  lib_file.read(&contents[0], contents.size());
+  if(lib_file.gcount() != (streamsize) contents.size()) {
+    cout << "Erro: arquivo " << lib_name << ".lib corrompido" << endl;
+    exit(3);
+  }
+
+  istringstream member_stream(contents.substr(0, members[member].size));
+  obj = new Modulo(member, member_stream);
+  if(obj->getErrorCode() == 0 && members[member].map_size > 0) {
+    istringstream map_stream(contents.substr(members[member].size));
+    obj->parseDebugMap(map_stream);
+  }
+  return obj;
+}
+
+// Writes a library with the given .obj files
+void Biblioteca::create(string t_lib_name, vector<string> obj_names)
+{
+  map<string, string> lib_index;
+  vector<string> contents, maps;
+  fstream obj_file, map_file, lib_file;
+  long offset = 0;
+
+  for(auto const& name : obj_names) {
+    Modulo obj(name);
+    obj.parse();
+    if(obj.getErrorCode() != 0) {
+      cout << "Erro: " << obj.getErrorMessage() << endl;
+      exit(obj.getErrorCode());
+    }
+    for(auto const& item : obj.getDefinitionsTable()) {
+      if(lib_index.count(item.first) > 0) {
+        cout << "Aviso: " << item.first << " já é definido por "
+             << lib_index[item.first] << ", ignorando " << name << endl;
+      } else {
+        lib_index[item.first] = name;
+      }
+    }
+
+    obj_file.open(name + ".obj", ios::in | ios::binary);
+    contents.push_back(string(istreambuf_iterator<char>(obj_file),
+                              istreambuf_iterator<char>()));
+    obj_file.close();
+
+    // The debug map is optional, as when linking the .obj itself
+    map_file.open(name + ".map", ios::in | ios::binary);
+    maps.push_back(string(istreambuf_iterator<char>(map_file),
+                          istreambuf_iterator<char>()));
+    map_file.close();
+  }
+
+  lib_file.open(t_lib_name + ".lib", ios::out | ios::binary);
+  if(!lib_file.is_open()) {
+    cout << "Erro: não é possível criar arquivo de saída " << t_lib_name << ".lib" << endl;
+    exit(4);
+  }
+
+  lib_file << "LIBRARY\n";
+  lib_file << "INDEX\n";
+  for(auto const& item : lib_index) {
+    lib_file << item.first << " " << item.second << "\n";
+  }
+  lib_file << "\n";
+  lib_file << "MEMBERS\n";
+  for(size_t i = 0; i < obj_names.size(); i++) {
+    lib_file << obj_names[i] << " " << offset << " " << contents[i].size()
+             << " " << maps[i].size() << "\n";
+    offset += contents[i].size() + maps[i].size();
+  }
+  lib_file << "\n";
+  for(size_t i = 0; i < obj_names.size(); i++) {
+    lib_file << contents[i] << maps[i];
+  }
+  lib_file.close();
+}
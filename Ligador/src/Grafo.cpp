@@ -0,0 +1,214 @@
+#include "Grafo.hpp"
+
+typedef enum {
+  JMP = 5,
+  JMPN = 6,
+  JMPP = 7,
+  JMPZ = 8,
+  COPY = 9,
+  STOP = 14
+} Opcode;
+
+using namespace std;
+
+Grafo::Grafo(vector<int> t_code, vector<int> t_relative, vector<int> t_external)
+{
+  code = t_code;
+  relative.insert(t_relative.begin(), t_relative.end());
+  external.insert(t_external.begin(), t_external.end());
+}
+
+Grafo::~Grafo()
+{
+}
+
+// Follows every path from the roots (jumps and fall-throughs) and splits the
+// reached instructions into basic blocks. Words never reached are data.
+void Grafo::build(vector<int> roots)
+{
+  vector<int> pending;
+  int address, opcode, size, target;
+
+  instructions.clear();
+  leaders.clear();
+  blocks.clear();
+  code_mask.assign(code.size(), false);
+
+  for(auto const& root : roots) {
+    if(decodable(root)) {
+      leaders.insert(root);
+      pending.push_back(root);
+    }
+  }
+
+  // Recursive traversal of the reachable instructions
+  while(!pending.empty()) {
+    address = pending.back();
+    pending.pop_back();
+
+    while(decodable(address) && instructions.count(address) == 0) {
+      opcode = code[address];
+      size = instructionSize(opcode);
+      instructions.insert(address);
+      for(int i = 0; i < size; i++) {
+        code_mask[address + i] = true;
+      }
+
+      if(opcode >= JMP && opcode <= JMPZ) {
+        // Jumps to other modules are resolved only after linking
+        if(external.count(address + 1) == 0) {
+          target = code[address + 1];
+          if(decodable(target)) {
+            leaders.insert(target);
+            pending.push_back(target);
+          }
+        }
+        if(opcode == JMP) {
+          break;
+        }
+        leaders.insert(address + size);
+      }
+      else if(opcode == STOP) {
+        break;
+      }
+      address += size;
+    }
+  }
+
+  // Splits the instructions in blocks, starting a new one at each leader
+  BasicBlock block;
+  int last = -1;
+  for(auto const& instruction : instructions) {
+    if(last == -1 || leaders.count(instruction) > 0 || block.end != instruction) {
+      if(last != -1) {
+        blocks[block.start] = block;
+      }
+      block.start = instruction;
+      block.successors.clear();
+    }
+    block.end = instruction + instructionSize(code[instruction]);
+    last = instruction;
+  }
+  if(last != -1) {
+    blocks[block.start] = block;
+  }
+
+  // Successors are given by the last instruction of each block
+  for(auto& item : blocks) {
+    BasicBlock& current = item.second;
+    address = *prev(instructions.lower_bound(current.end));
+    opcode = code[address];
+    if(opcode >= JMP && opcode <= JMPZ && external.count(address + 1) == 0
+       && blocks.count(code[address + 1]) > 0) {
+      current.successors.push_back(code[address + 1]);
+    }
+    if(opcode != JMP && opcode != STOP && blocks.count(current.end) > 0) {
+      current.successors.push_back(current.end);
+    }
+  }
+}
+
+// Auxiliary methods
+
+int Grafo::instructionSize(int opcode)
+{
+  if(opcode == COPY)
+    return 3;
+  if(opcode == STOP)
+    return 1;
+  return 2;
+}
+
+// An instruction can start at an address if its opcode is valid and all of
+// its operands are inside the code (and relocatable, when that is known)
+bool Grafo::decodable(int address)
+{
+  int size;
+
+  if(address < 0 || address >= (int) code.size())
+    return false;
+  if(code[address] < 1 || code[address] > STOP)
+    return false;
+
+  size = instructionSize(code[address]);
+  if(address + size > (int) code.size())
+    return false;
+
+  if(!relative.empty()) {
+    for(int i = 1; i < size; i++) {
+      if(relative.count(address + i) == 0)
+        return false;
+    }
+  }
+  return true;
+}
+
+// Getters
+
+map<int, BasicBlock> Grafo::getBlocks()
+{
+  return blocks;
+}
+
+bool Grafo::isCode(int address)
+{
+  if(address < 0 || address >= (int) code_mask.size())
+    return false;
+  return code_mask[address];
+}
+
+// Words that are read or written by reachable instructions
+vector<int> Grafo::getDataAddresses()
+{
+  set<int> data;
+  int size;
+
+  for(auto const& instruction : instructions) {
+    size = instructionSize(code[instruction]);
+    if(code[instruction] >= JMP && code[instruction] <= JMPZ)
+      continue;
+    for(int i = 1; i < size; i++) {
+      if(external.count(instruction + i) == 0 && !isCode(code[instruction + i]))
+        data.insert(code[instruction + i]);
+    }
+  }
+  return vector<int>(data.begin(), data.end());
+}
+
+// Words that are neither reachable code nor referenced data
+vector<int> Grafo::getUnreachableAddresses()
+{
+  vector<int> unreachable, data = getDataAddresses();
+  set<int> used(data.begin(), data.end());
+
+  for(int i = 0; i < (int) code.size(); i++) {
+    if(!isCode(i) && used.count(i) == 0)
+      unreachable.push_back(i);
+  }
+  return unreachable;
+}
+
+// Writes the blocks, one per line (start, end and successors), and then
+// the unreachable addresses
+void Grafo::write(ostream& output)
+{
+  vector<int> unreachable = getUnreachableAddresses();
+
+  output << "BLOCKS" << "\n";
+  for(auto const& item : blocks) {
+    output << item.second.start << " " << item.second.end;
+    for(auto const& successor : item.second.successors) {
+      output << " " << successor;
+    }
+    output << "\n";
+  }
+  output << "\n";
+
+  output << "UNREACHABLE" << "\n";
+  for(size_t i = 0; i < unreachable.size(); i++) {
+    output << (i > 0 ? " " : "") << unreachable[i];
+  }
+  if(!unreachable.empty()) {
+    output << "\n";
+  }
+}
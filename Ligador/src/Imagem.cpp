@@ -0,0 +1,314 @@
+#include "Imagem.hpp"
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define MAGIC "SBEZ"
+#define BINARY_MAGIC "SBEB"
+#define BINARY_HEADER 8    // Magic and number of words
+#define MIN_MATCH 3        // Shorter repeats are cheaper as literals
+#define HASH_BITS 14
+#define MAX_WORDS 65536    // 16-bit memory
+
+using namespace std;
+
+// Auxiliary functions
+
+static void putVarint(string& buffer, size_t value)
+{
+  while(value >= 0x80) {
+    buffer += (char) ((value & 0x7F) | 0x80);
+    value >>= 7;
+  }
+  buffer += (char) value;
+}
+
+// Reads a varint straight from the stream buffer. Returns false at the end
+// of the stream or if the number is too long to be valid.
+static bool getVarint(streambuf* input, size_t& value)
+{
+  int byte;
+
+  value = 0;
+  for(int shift = 0; shift < 28; shift += 7) {
+    byte = input->sbumpc();
+    if(byte == char_traits<char>::eof()) {
+      return false;
+    }
+    value |= (size_t) (byte & 0x7F) << shift;
+    if((byte & 0x80) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static void putLiterals(string& buffer, const vector<uint16_t>& code,
+                        size_t start, size_t end)
+{
+  if(start == end) {
+    return;
+  }
+  putVarint(buffer, (end - start) << 1);
+  for(size_t i = start; i < end; i++) {
+    putVarint(buffer, code[i]);
+  }
+}
+
+static size_t hashWords(const vector<uint16_t>& code, size_t position)
+{
+  uint32_t key = code[position] | (uint32_t) code[position + 1] << 16;
+
+  key ^= (uint32_t) code[position + 2] * 0x9E3779B1u;
+  return (key * 0x85EBCA6Bu) >> (32 - HASH_BITS);
+}
+
+// Writers
+
+// Writes the .e text: each word followed by a space, then a new line
+void writeTextImage(ostream& output, const vector<uint16_t>& code,
+                    const vector<bool>& addresses)
+{
+  string text;
+
+  for(size_t i = 0; i < code.size(); i++) {
+    if(i < addresses.size() && addresses[i]) {
+      text += to_string(code[i]);
+    } else {
+      text += to_string((int16_t) code[i]);
+    }
+    text += ' ';
+  }
+  output << text << endl;
+}
+
+// Greedy LZ: each position is looked up by its next three words in a hash
+// table of the last position seen with them. The image is built in memory
+// and written at once.
+void writeCompressedImage(ostream& output, const vector<uint16_t>& code)
+{
+  vector<long> last(1 << HASH_BITS, -1);
+  string buffer = MAGIC;
+  size_t literal_start = 0, i = 0, length, candidate = 0;
+
+  putVarint(buffer, code.size());
+
+  while(i + MIN_MATCH <= code.size()) {
+    size_t key = hashWords(code, i);
+
+    length = 0;
+    if(last[key] >= 0) {
+      candidate = last[key];
+      while(i + length < code.size() && code[candidate + length] == code[i + length]) {
+        length++;
+      }
+    }
+    last[key] = i;
+
+    if(length < MIN_MATCH) {
+      i++;
+      continue;
+    }
+
+    putLiterals(buffer, code, literal_start, i);
+    putVarint(buffer, ((length - MIN_MATCH) << 1) | 1);
+    putVarint(buffer, i - candidate);
+
+    // The repeated positions are indexed too, for the next matches
+    for(size_t j = i + 1; j < i + length && j + MIN_MATCH <= code.size(); j++) {
+      last[hashWords(code, j)] = j;
+    }
+    i += length;
+    literal_start = i;
+  }
+  putLiterals(buffer, code, literal_start, code.size());
+
+  output.write(buffer.data(), buffer.size());
+}
+
+// Loader
+
+// Loads an image in any format (the binary ones start with "SBEZ" and
+// "SBEB"). The compressed blocks are decoded as they are read, straight into
+// code. Returns false if the image is corrupt.
+bool loadImage(istream& input, vector<uint16_t>& code)
+{
+  streambuf* buffer = input.rdbuf();
+  string magic(4, ' ');
+  unsigned char bytes[4];
+  size_t count = 0, header, value, length, distance;
+  int word;
+
+  code.clear();
+
+  if(input.peek() != MAGIC[0]) {
+    while(input >> word) {
+      if(word < -32768 || word > 65535) {
+        return false;
+      }
+      code.push_back((uint16_t) word);
+    }
+    return input.eof();
+  }
+
+  if(buffer->sgetn(&magic[0], 4) != 4) {
+    return false;
+  }
+
+  if(magic == BINARY_MAGIC) {
+    if(buffer->sgetn((char*) bytes, 4) != 4) {
+      return false;
+    }
+    for(int i = 0; i < 4; i++) {
+      count |= (size_t) bytes[i] << (8 * i);
+    }
+    if(count > MAX_WORDS) {
+      return false;
+    }
+    code.reserve(count);
+    while(code.size() < count) {
+      if(buffer->sgetn((char*) bytes, 2) != 2) {
+        return false;
+      }
+      code.push_back(bytes[0] | bytes[1] << 8);
+    }
+    return true;
+  }
+
+  if(magic != MAGIC || !getVarint(buffer, count) || count > MAX_WORDS) {
+    return false;
+  }
+  code.reserve(count);
+
+  while(code.size() < count) {
+    if(!getVarint(buffer, header)) {
+      return false;
+    }
+    if((header & 1) == 0) {
+      length = header >> 1;
+      if(code.size() + length > count) {
+        return false;
+      }
+      for(size_t i = 0; i < length; i++) {
+        if(!getVarint(buffer, value) || value > 0xFFFF) {
+          return false;
+        }
+        code.push_back((uint16_t) value);
+      }
+    } else {
+      length = (header >> 1) + MIN_MATCH;
+      if(!getVarint(buffer, distance) || distance == 0 ||
+         distance > code.size() || code.size() + length > count) {
+        return false;
+      }
+      // Word by word, since the repeat may overlap what it writes (no
+      // reallocation happens, the vector was reserved for count words)
+      for(size_t i = 0; i < length; i++) {
+        code.push_back(code[code.size() - distance]);
+      }
+    }
+  }
+
+  return true;
+}
+
+// Binary image
+
+void writeBinaryImage(ostream& output, const vector<uint16_t>& code)
+{
+  string buffer = BINARY_MAGIC;
+
+  for(int shift = 0; shift < 32; shift += 8) {
+    buffer += (char) ((code.size() >> shift) & 0xFF);
+  }
+  for(auto const& word : code) {
+    buffer += (char) (word & 0xFF);
+    buffer += (char) (word >> 8);
+  }
+
+  output.write(buffer.data(), buffer.size());
+}
+
+ImagemMapeada::ImagemMapeada()
+{
+  mapping = nullptr;
+  mapping_size = 0;
+  words = nullptr;
+  word_count = 0;
+}
+
+ImagemMapeada::~ImagemMapeada()
+{
+  this->close();
+}
+
+// Maps the file name. Returns false if it can't be mapped or isn't a valid
+// binary image.
+bool ImagemMapeada::open(string name)
+{
+  struct stat file_stat;
+  unsigned char* bytes;
+  size_t count = 0;
+  int file;
+
+  this->close();
+
+  if(__BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__) {
+    return false;
+  }
+
+  file = ::open(name.c_str(), O_RDONLY);
+  if(file < 0) {
+    return false;
+  }
+  if(fstat(file, &file_stat) != 0 || file_stat.st_size < BINARY_HEADER) {
+    ::close(file);
+    return false;
+  }
+
+  mapping_size = file_stat.st_size;
+  mapping = mmap(nullptr, mapping_size, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                 file, 0);
+  ::close(file); // The mapping keeps the file
+  if(mapping == MAP_FAILED) {
+    mapping = nullptr;
+    return false;
+  }
+
+  bytes = (unsigned char*) mapping;
+  for(int i = 0; i < 4; i++) {
+    count |= (size_t) bytes[4 + i] << (8 * i);
+  }
+  if(string((char*) bytes, 4) != BINARY_MAGIC || count > MAX_WORDS ||
+     mapping_size != BINARY_HEADER + 2 * count) {
+    this->close();
+    return false;
+  }
+
+  words = (uint16_t*) (bytes + BINARY_HEADER);
+  word_count = count;
+  return true;
+}
+
+void ImagemMapeada::close()
+{
+  if(mapping != nullptr) {
+    munmap(mapping, mapping_size);
+  }
+  mapping = nullptr;
+  mapping_size = 0;
+  words = nullptr;
+  word_count = 0;
+}
+
+uint16_t* ImagemMapeada::getWords()
+{
+  return words;
+}
+
+size_t ImagemMapeada::getSize()
+{
+  return word_count;
+}
@@ -9,6 +9,11 @@
 #include <fstream>
 #include <iomanip>
 #include "Modulo.hpp"
+#include "Grafo.hpp"
+#include "Biblioteca.hpp"
+#include "Imagem.hpp"
+#include "Linker.hpp"
+#include "Stats.hpp"
 
 // Defines:
 #define DEBUG 0
@@ -19,40 +24,114 @@ using namespace std;
 // Function headers
 void printTable(map<string, int> table);
 void printVectorInt(vector<int> items);
-vector<int> concatenateCodes(vector<Modulo*> objs);
+void checkModule(Modulo* obj);
+void extractLibraryMembers(vector<Modulo*>& objs, vector<Biblioteca*> libs);
+long writeDebugMap(string name, vector<Modulo*> objs);
+long writeControlFlowGraph(string name, vector<uint16_t> code,
+                           vector<bool> addresses);
+long writePartialObject(string name, vector<Modulo*> objs,
+                        vector<int> correction_table, map<string, int> gdt);
 
 // Main function:
 int main(int argc, char const *argv[])
 {
 
-  if(argc < 2) {
-    cout << "Erro: Insira no mínimo 1 arquivo para ligar" << endl;
-    cout << "Modo de uso: ligador nome_do_arquivo_sem_obj ..." << endl;
-    exit(1);
-  }
-
-  int num_modulos = argc-1;
   vector<Modulo*> objs;
+  vector<string> obj_names, lib_names;
+  vector<Biblioteca*> libs;
+  string archive_name, partial_name;
+  bool garbage_collect = false, show_stats = false, compress = false, binary = false;
+  bool write_cfg = false;
+
+  // Time and counters of each step (written with --stats)
+  Stats stats;
+  long bytes_read = 0, bytes_written = 0, relocations = 0, uses = 0;
 
-  int correction_accumulator;
   vector<int> correction_table;
 
   map<string, int> global_definitions_table;
 
-  vector<int> output_code;
+  vector<uint16_t> output_code;
   string output_name;
-  fstream output_file;
+  fstream output_file, map_file;
+  bool has_debug_map = false;
 
-  // Opens each file
+  // Reads options and the names of the files
   for(int i = 1; i < argc; i++) {
-    objs.push_back(new Modulo(string(argv[i])));
+    string arg = argv[i];
+    if(arg == "--gc") {
+      garbage_collect = true;
+    } else if(arg == "--stats") {
+      show_stats = true;
+    } else if(arg == "--compress") {
+      compress = true;
+    } else if(arg == "--binary") {
+      binary = true;
+    } else if(arg == "--cfg") {
+      write_cfg = true;
+    } else if((arg == "--lib" || arg == "--archive" || arg == "--partial") && i + 1 < argc) {
+      if(arg == "--lib") {
+        lib_names.push_back(argv[++i]);
+      } else if(arg == "--archive") {
+        archive_name = argv[++i];
+      } else {
+        partial_name = argv[++i];
+      }
+    } else if(arg[0] == '-') {
+      cout << "Erro: opção desconhecida " << arg << endl;
+      exit(1);
+    } else {
+      obj_names.push_back(arg);
+    }
+  }
+
+  if(obj_names.size() < 1) {
+    cout << "Erro: Insira no mínimo 1 arquivo para ligar" << endl;
+    cout << "Modo de uso: ligador [--gc] [--stats] [--cfg] [--compress | --binary] [--lib biblioteca] nome_do_arquivo_sem_obj ..." << endl;
+    cout << "             ligador --partial saida [--lib biblioteca] nome_do_arquivo_sem_obj ..." << endl;
+    cout << "             ligador --archive biblioteca nome_do_arquivo_sem_obj ..." << endl;
+    exit(1);
+  }
+
+  // Archive mode: only writes the library
+  if(archive_name != "") {
+    Biblioteca::create(archive_name, obj_names);
+    cout << "Biblioteca salva em: " << archive_name << ".lib" << endl;
+    return 0;
+  }
+
+  stats.start("parse");
+
+  // Opens each file
+  for(auto const& name : obj_names) {
+    objs.push_back(new Modulo(name));
+    checkModule(objs.back());
   }
 
-  // Parses each file
+  // Parses each file (and its debug map, if there is one)
   for(auto const& obj : objs) {
     obj->parse();
+    obj->parseDebugMap();
+    checkModule(obj);
+  }
+
+  // Libraries only contribute the members that define missing labels
+  for(auto const& name : lib_names) {
+    libs.push_back(new Biblioteca(name));
+  }
+  extractLibraryMembers(objs, libs);
+  for(auto const& lib : libs) {
+    delete lib;
   }
 
+  for(auto const& obj : objs) {
+    bytes_read += obj->getBytesRead();
+    has_debug_map = has_debug_map || obj->hasDebugMap();
+  }
+  stats.count("modules", objs.size());
+  stats.count("bytes_read", bytes_read);
+  stats.stop();
+
   // Prints debug info
   if(DEBUG >= 1){
     for(auto const& obj : objs) {
@@ -60,55 +139,115 @@ int main(int argc, char const *argv[])
     }
   }
 
-  // Generates Correction Factor Table
-  correction_accumulator = 0;
-  for (auto const &obj : objs) {
-    correction_table.push_back(correction_accumulator);
-    correction_accumulator += obj->getCodeSize();
-  }
+  stats.start("resolve");
 
-  if(DEBUG >= 1) {
-    cout << "Correction Table" << endl;
-    printVectorInt(correction_table);
+  // Drops modules that can't be reached from the first one
+  if(garbage_collect) {
+    objs = removeUnusedModules(objs);
   }
 
-  // Generates Global Definitions Table
-  for(int i = 0; i < num_modulos; i++) {
-    for(auto const& item : objs[i]->getDefinitionsTable()) {
-      global_definitions_table[item.first] = item.second + correction_table[i];
-    }
+  // Relocates the modules and resolves their cross references
+  output_code = linkModules(objs, correction_table, global_definitions_table);
+  for(auto const& obj : objs) {
+    checkModule(obj);
   }
 
   if(DEBUG >= 1) {
+    cout << "Correction Table" << endl;
+    printVectorInt(correction_table);
     cout << "Global Definitions Table" << endl;
     printTable(global_definitions_table);
   }
 
-  for(int i = 0; i < num_modulos; i++) {
-    objs[i]->fixCrossReferences(global_definitions_table);
-    objs[i]->fixRelativeAddresses(correction_table[i]);
+  for(auto const& obj : objs) {
+    relocations += obj->getRelativeAddresses().size();
+    for(auto const& item : obj->getUseTable()) {
+      uses += item.second.size();
+    }
   }
-
-  output_code = concatenateCodes(objs);
+  stats.count("modules", objs.size());
+  stats.count("symbols", global_definitions_table.size());
+  stats.count("relocations", relocations);
+  stats.count("uses", uses);
+  stats.count("words", output_code.size());
+  stats.stop();
 
   if(DEBUG >= 1) {
     cout << "Outputted Code" << endl;
-    printVectorInt(output_code);
+    printVectorInt(vector<int>(output_code.begin(), output_code.end()));
   }
 
-  output_name = argv[1]; // Outputfile is name of the first file
-  output_name += ".e"; // followed by .e
+  // Partial link: the result is another .obj, with the labels that are
+  // still missing kept in its use table
+  if(partial_name != "") {
+    stats.start("write");
+    bytes_written = writePartialObject(partial_name, objs, correction_table,
+                                       global_definitions_table);
+    if(has_debug_map) {
+      bytes_written += writeDebugMap(partial_name + ".map", objs);
+    }
+    stats.count("bytes_written", bytes_written);
+    stats.stop();
+    if(show_stats) {
+      map_file.open(partial_name + ".stats.json", ios::out);
+      if(!map_file.is_open()) {
+        cout << "Erro: não é possível criar arquivo de saída " << partial_name << ".stats.json" << endl;
+        exit(4);
+      }
+      stats.write(map_file, "ligador", partial_name + ".obj");
+      map_file.close();
+    }
+    for(auto const& obj : objs) {
+      delete obj;
+    }
+    cout << "Módulos ligados parcialmente e salvos em: " << partial_name << ".obj" << endl;
+    return 0;
+  }
 
-  output_file.open(output_name, ios::out);
+  output_name = obj_names[0]; // Outputfile is name of the first file
+  output_name += compress ? ".ez" : binary ? ".eb" : ".e"; // followed by .e (or .ez, .eb)
+
+  stats.start("write");
+
+  output_file.open(output_name, ios::out | ios::binary);
   if(!output_file.is_open()) {
     cout << "Erro: não é possível criar arquivo de saída " << output_name << endl;
     exit(4);
   }
 
-  for(auto const& i : output_code) {
-    output_file << i << " ";
+  if(compress) {
+    writeCompressedImage(output_file, output_code);
+  } else if(binary) {
+    writeBinaryImage(output_file, output_code);
+  } else {
+    writeTextImage(output_file, output_code,
+                   findAddressWords(objs, correction_table));
+  }
+  bytes_written = output_file.tellp();
+
+  // Merges the relocated debug maps
+  if(has_debug_map) {
+    bytes_written += writeDebugMap(output_name + ".map", objs);
+  }
+
+  // Basic blocks of the executable and the words no path reaches
+  if(write_cfg) {
+    bytes_written += writeControlFlowGraph(output_name + ".cfg", output_code,
+                                           findAddressWords(objs, correction_table));
+  }
+
+  stats.count("bytes_written", bytes_written);
+  stats.stop();
+
+  if(show_stats) {
+    map_file.open(output_name + ".stats.json", ios::out);
+    if(!map_file.is_open()) {
+      cout << "Erro: não é possível criar arquivo de saída " << output_name << ".stats.json" << endl;
+      exit(4);
+    }
+    stats.write(map_file, "ligador", output_name);
+    map_file.close();
   }
-  output_file << endl;
 
   // Clean up (free allocated memory)
   for(auto const& obj : objs) {
@@ -161,15 +300,120 @@ void printVectorInt(vector<int> items)
   cout << endl << endl;
 }
 
-vector<int> concatenateCodes(vector<Modulo*> objs)
+// Stops the program if the module couldn't be read
+void checkModule(Modulo* obj)
 {
-  vector<int> code;
+  if(obj->getErrorCode() != 0) {
+    cout << "Erro: " << obj->getErrorMessage() << endl;
+    exit(obj->getErrorCode());
+  }
+}
 
-  for(auto const& obj : objs) {
-    for(auto const& code_byte : obj->getCode()) {
-      code.push_back(code_byte);
+// Appends to objs the library members that define labels used but not
+// defined so far, repeating while the new members need more labels
+void extractLibraryMembers(vector<Modulo*>& objs, vector<Biblioteca*> libs)
+{
+  map<string, bool> defined, loaded;
+  string member;
+  bool changed = true;
+
+  while(changed) {
+    changed = false;
+    for(auto const& obj : objs) {
+      for(auto const& item : obj->getDefinitionsTable()) {
+        defined[item.first] = true;
+      }
+    }
+    for(size_t i = 0; i < objs.size(); i++) {
+      for(auto const& item : objs[i]->getUseTable()) {
+        if(defined.count(item.first) > 0) {
+          continue;
+        }
+        // Only the first library that defines the label is used
+        for(auto const& lib : libs) {
+          member = lib->findMember(item.first);
+          if(member == "") {
+            continue;
+          }
+          if(loaded.count(member) == 0) {
+            loaded[member] = true;
+            objs.push_back(lib->extract(member));
+            checkModule(objs.back());
+            for(auto const& definition : objs.back()->getDefinitionsTable()) {
+              defined[definition.first] = true;
+            }
+            changed = true;
+          }
+          break;
+        }
+      }
+    }
+  }
+}
+
+// Writes the merged debug map to a file. Returns the number of bytes written.
+long writeDebugMap(string name, vector<Modulo*> objs)
+{
+  fstream map_file;
+  long bytes;
+
+  map_file.open(name, ios::out);
+  if(!map_file.is_open()) {
+    cout << "Erro: não é possível criar arquivo de saída " << name << endl;
+    exit(4);
+  }
+  writeDebugMap(map_file, objs);
+  bytes = map_file.tellp();
+  map_file.close();
+  return bytes;
+}
+
+// Writes the control flow graph of the linked code, from address 0, to a
+// file. The words that are addresses are the operands, the graph follows
+// only instructions whose operands are all addresses. Returns the number of
+// bytes written.
+long writeControlFlowGraph(string name, vector<uint16_t> code,
+                           vector<bool> addresses)
+{
+  vector<int> operands;
+  fstream cfg_file;
+  long bytes;
+
+  for(size_t i = 0; i < addresses.size(); i++) {
+    if(addresses[i]) {
+      operands.push_back(i);
     }
   }
 
-  return code;
+  Grafo graph(vector<int>(code.begin(), code.end()), operands, {});
+  graph.build({0});
+
+  cfg_file.open(name, ios::out);
+  if(!cfg_file.is_open()) {
+    cout << "Erro: não é possível criar arquivo de saída " << name << endl;
+    exit(4);
+  }
+  graph.write(cfg_file);
+  bytes = cfg_file.tellp();
+  cfg_file.close();
+  return bytes;
+}
+
+// Writes the partially linked modules to name.obj. Returns the number of
+// bytes written.
+long writePartialObject(string name, vector<Modulo*> objs,
+                        vector<int> correction_table, map<string, int> gdt)
+{
+  fstream obj_file;
+  long bytes;
+
+  obj_file.open(name + ".obj", ios::out);
+  if(!obj_file.is_open()) {
+    cout << "Erro: não é possível criar arquivo de saída " << name << ".obj" << endl;
+    exit(4);
+  }
+  writePartialObject(obj_file, objs, correction_table, gdt);
+  bytes = obj_file.tellp();
+  obj_file.close();
+  return bytes;
 }
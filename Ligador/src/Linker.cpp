@@ -0,0 +1,196 @@
+#include "Linker.hpp"
+#include <iostream>
+
+using namespace std;
+
+vector<uint16_t> linkModules(vector<Modulo*> objs, vector<int>& correction_table,
+                             map<string, int>& gdt)
+{
+  int correction_accumulator = 0;
+  int num_modulos = objs.size();
+
+  // Generates Correction Factor Table
+  correction_table.clear();
+  for (auto const &obj : objs) {
+    correction_table.push_back(correction_accumulator);
+    correction_accumulator += obj->getCodeSize();
+  }
+
+  // Generates Global Definitions Table
+  gdt.clear();
+  for(int i = 0; i < num_modulos; i++) {
+    for(auto const& item : objs[i]->getDefinitionsTable()) {
+      gdt[item.first] = item.second + correction_table[i];
+    }
+  }
+
+  for(int i = 0; i < num_modulos; i++) {
+    objs[i]->fixCrossReferences(gdt);
+    objs[i]->fixRelativeAddresses(correction_table[i]);
+  }
+
+  return concatenateCodes(objs);
+}
+
+vector<uint16_t> concatenateCodes(vector<Modulo*> objs)
+{
+  vector<uint16_t> code, module_code;
+
+  for(auto const& obj : objs) {
+    module_code = obj->getCode();
+    code.insert(code.end(), module_code.begin(), module_code.end());
+  }
+
+  return code;
+}
+
+// Marks the words of the linked code that hold addresses: the relative ones
+// and the uses of labels of each module, moved to its place.
+vector<bool> findAddressWords(vector<Modulo*> objs, vector<int> correction_table)
+{
+  vector<bool> addresses;
+  size_t size;
+
+  for(size_t i = 0; i < objs.size(); i++) {
+    size = objs[i]->getCodeSize();
+    addresses.resize(correction_table[i] + size, false);
+    for(auto const& address : objs[i]->getRelativeAddresses()) {
+      if(address < size) {
+        addresses[correction_table[i] + address] = true;
+      }
+    }
+    for(auto const& item : objs[i]->getUseTable()) {
+      for(auto const& address : item.second) {
+        if(address < size) {
+          addresses[correction_table[i] + address] = true;
+        }
+      }
+    }
+  }
+
+  return addresses;
+}
+
+// Keeps only the modules reachable from the first one, following the labels
+// of each use table to the module that defines them. The others are freed.
+vector<Modulo*> removeUnusedModules(vector<Modulo*> objs)
+{
+  map<string, int> definer;
+  vector<bool> used(objs.size(), false);
+  vector<int> pending;
+  vector<Modulo*> kept;
+  int current;
+
+  for(int i = 0; i < (int) objs.size(); i++) {
+    for(auto const& item : objs[i]->getDefinitionsTable()) {
+      definer[item.first] = i;
+    }
+  }
+
+  used[0] = true;
+  pending.push_back(0);
+  while(!pending.empty()) {
+    current = pending.back();
+    pending.pop_back();
+    for(auto const& item : objs[current]->getUseTable()) {
+      if(definer.count(item.first) > 0 && !used[definer[item.first]]) {
+        used[definer[item.first]] = true;
+        pending.push_back(definer[item.first]);
+      }
+    }
+  }
+
+  for(int i = 0; i < (int) objs.size(); i++) {
+    if(used[i]) {
+      kept.push_back(objs[i]);
+    } else {
+      cout << "Módulo " << objs[i]->getName() << " não é referenciado e foi removido" << endl;
+      delete objs[i];
+    }
+  }
+
+  return kept;
+}
+
+// Writes the relocated debug maps of all modules, one entry per line:
+// address, module, line and label.
+void writeDebugMap(ostream& output, vector<Modulo*> objs)
+{
+  for(auto const& obj : objs) {
+    for(auto const& entry : obj->getDebugMap()) {
+      output << entry.address << " " << entry.module << " " << entry.line;
+      if(entry.label != "") {
+        output << " " << entry.label;
+      }
+      output << "\n";
+    }
+  }
+}
+
+// Writes the modules (already fixed and relocated) as a single .obj. Uses
+// of labels defined by the modules were resolved by fixCrossReferences;
+// the others stay in the use table. Every relative address is kept, so the
+// final link relocates the merged module as a whole.
+void writePartialObject(ostream& output, vector<Modulo*> objs,
+                        vector<int> correction_table, map<string, int> gdt)
+{
+  map<string, vector<uint16_t>> use_table;
+  vector<uint16_t> relative, code;
+  vector<bool> addresses = findAddressWords(objs, correction_table);
+  int previous;
+
+  for(size_t i = 0; i < objs.size(); i++) {
+    for(auto const& item : objs[i]->getUseTable()) {
+      if(gdt.count(item.first) == 0) {
+        for(auto const& address : item.second) {
+          use_table[item.first].push_back(address + correction_table[i]);
+        }
+      }
+    }
+    for(auto const& address : objs[i]->getRelativeAddresses()) {
+      relative.push_back(address + correction_table[i]);
+    }
+  }
+  code = concatenateCodes(objs);
+
+  // Addresses are written as in the montador's .obj: the first one, then
+  // the distance from each one to the previous
+  output << "TABLE USE" << "\n";
+  for(auto const& item : use_table) {
+    output << item.first;
+    previous = 0;
+    for(auto const& address : item.second) {
+      output << " " << address - previous;
+      previous = address;
+    }
+    output << "\n";
+  }
+  output << "\n";
+
+  output << "TABLE DEFINITION" << "\n";
+  for(auto const& item : gdt) {
+    output << item.first << " " << item.second << "\n";
+  }
+  output << "\n";
+
+  output << "RELATIVE DELTA" << "\n";
+  previous = 0;
+  for(size_t i = 0; i < relative.size(); i++) {
+    output << (i > 0 ? " " : "") << relative[i] - previous;
+    previous = relative[i];
+  }
+  if(!relative.empty()) {
+    output << "\n";
+  }
+  output << "\n";
+
+  output << "CODE" << "\n";
+  for(size_t i = 0; i < code.size(); i++) {
+    output << (i > 0 ? " " : "");
+    if(addresses[i]) {
+      output << code[i];
+    } else {
+      output << (int16_t) code[i];
+    }
+  }
+}
@@ -6,6 +6,8 @@
 #include <regex>
 #include <iomanip>
 #include <algorithm>
+#include <iterator>
+#include <sstream>
 
 #define DEBUG 0
 
@@ -22,9 +24,38 @@ using namespace std;
 Modulo::Modulo(string t_obj_name)
 {
   obj_name = t_obj_name;
+  has_debug_map = false;
+  bytes_read = 0;
+  error_code = 0;
   this->openStream();
 }
 
+// Module read from memory (e.g. a library member) instead of a .obj file
+Modulo::Modulo(string t_obj_name, istream& source)
+{
+  obj_name = t_obj_name;
+  has_debug_map = false;
+  bytes_read = 0;
+  error_code = 0;
+  this->parse(source);
+}
+
+// Module handed over by the assembler in memory, nothing to parse
+Modulo::Modulo(string t_obj_name, map<string, vector<uint16_t>> t_use_table,
+               map<string, int> t_definitions_table, vector<uint16_t> t_relative,
+               vector<uint16_t> t_code, vector<DebugEntry> t_debug_map)
+{
+  obj_name = t_obj_name;
+  use_table = t_use_table;
+  definitions_table = t_definitions_table;
+  relative = t_relative;
+  code = t_code;
+  debug_map = t_debug_map;
+  has_debug_map = !debug_map.empty();
+  bytes_read = 0;
+  error_code = 0;
+}
+
 Modulo::~Modulo()
 {
   if(obj_file.is_open()){
@@ -37,23 +68,34 @@ void Modulo::openStream()
   if(obj_name != ""){
     obj_file.open(obj_name + ".obj", ios::in);
     if (!obj_file.is_open()) {
-      cout << "Erro: arquivo " << obj_name << ".obj não existe!" << endl;
-      exit(2);
+      error_code = 2;
+      error_message = "arquivo " + obj_name + ".obj não existe!";
     }
   }
 }
 
 void Modulo::parse()
+{
+  this->parse(obj_file);
+}
+
+// Reads a .obj. The use table may have one line per use or one line per
+// label, and the relative addresses may be absolute (RELATIVE) or delta
+// encoded (RELATIVE DELTA), as the montador writes them now.
+void Modulo::parse(istream& source)
 {
   string file_line, label;
   int address;
+  vector<uint16_t> addresses;
+  bool relative_delta = false;
 
-  regex table_definition_regex("^TABLE DEFINITION$");
-  regex table_use_regex("^TABLE USE$");
-  regex relative_regex("^RELATIVE$");
-  regex code_regex("^CODE$");
-  regex blank_line_regex("^[ \t]*$");
-  regex label_address_regex("^([A-Za-z_][A-Za-z_\\d]*) (\\d+)$");
+  static const regex table_definition_regex("^TABLE DEFINITION$");
+  static const regex table_use_regex("^TABLE USE$");
+  static const regex relative_regex("^RELATIVE( DELTA)?$");
+  static const regex code_regex("^CODE$");
+  static const regex blank_line_regex("^[ \t]*$");
+  static const regex label_address_regex("^([A-Za-z_][A-Za-z_\\d]*) (\\d+)$");
+  static const regex label_addresses_regex("^([A-Za-z_][A-Za-z_\\d]*) (.+)$");
   //regex multiple_numbers_regex("^(\\d+)+$");
 
   smatch search_matches;
@@ -61,7 +103,8 @@ void Modulo::parse()
   Section section = NONE;
 
   // Iterates over all .obj lines
-  while(getline(obj_file, file_line)) {
+  while(getline(source, file_line)) {
+    bytes_read += file_line.size() + 1;
 
     if(DEBUG >= 2){
       cout << file_line << endl;
@@ -77,6 +120,7 @@ void Modulo::parse()
     // Finds RELATIVE
     else if(regex_search(file_line, search_matches, relative_regex)) {
       section = RELATIVE;
+      relative_delta = search_matches[1].matched;
     }
     // Finds CODE
     else if(regex_search(file_line, search_matches, code_regex)) {
@@ -95,28 +139,43 @@ void Modulo::parse()
           address = stoi(search_matches[2].str());
           definitions_table[label] = address;
         } else {
-          cout << "Erro: arquivo .obj corrompido" << endl;
-          exit(3);
+          error_code = 3;
+          error_message = "arquivo .obj corrompido";
+          return;
         }
         break;
       case USE_TABLE:
-        // Reads Label and address
-        if(regex_search(file_line, search_matches, label_address_regex)) {
+        // Reads Label and its addresses (the first one, then deltas)
+        if(regex_search(file_line, search_matches, label_addresses_regex) &&
+           splitStringToWords(search_matches[2].str(), addresses)) {
           label = search_matches[1].str();
-          address = stoi(search_matches[2].str());
-          use_table[label].push_back(address);
+          accumulateDeltas(addresses);
+          use_table[label].insert(use_table[label].end(), addresses.begin(),
+                                  addresses.end());
         } else {
-          cout << "Erro: arquivo .obj corrompido" << endl;
-          exit(3);
+          error_code = 3;
+          error_message = "arquivo .obj corrompido";
+          return;
         }
         break;
       case RELATIVE:
         // Splits line on spaces and gets all relative addresses
-        relative = splitStringToInts(file_line);
+        if(!splitStringToWords(file_line, relative)) {
+          error_code = 3;
+          error_message = "arquivo .obj corrompido";
+          return;
+        }
+        if(relative_delta) {
+          accumulateDeltas(relative);
+        }
         break;
       case CODE:
-        // Splits line on spaces and gets each byte of the machine code
-        code = splitStringToInts(file_line);
+        // Splits line on spaces and gets each word of the machine code
+        if(!splitStringToWords(file_line, code)) {
+          error_code = 3;
+          error_message = "arquivo .obj corrompido";
+          return;
+        }
         break;
       default:
         cout << "Erro: Linha inválida!" << endl;
@@ -129,14 +188,68 @@ void Modulo::parse()
   }
 }
 
+void Modulo::parseDebugMap()
+{
+  fstream map_file;
+
+  // The debug map is optional, modules assembled without it are still valid
+  map_file.open(obj_name + ".map", ios::in);
+  if(!map_file.is_open()) {
+    return;
+  }
+
+  this->parseDebugMap(map_file);
+  map_file.close();
+}
+
+void Modulo::parseDebugMap(istream& source)
+{
+  string file_line;
+  smatch search_matches;
+
+  // "address line [label]", or "address module line [label]" when the
+  // map comes from a partial link of several modules
+  static const regex map_entry_regex("^(\\d+) (\\d+)(?: ([A-Za-z_][A-Za-z_\\d]*))?$");
+  static const regex merged_entry_regex("^(\\d+) (\\S+) (\\d+)(?: ([A-Za-z_][A-Za-z_\\d]*))?$");
+
+  has_debug_map = true;
+  while(getline(source, file_line)) {
+    if(regex_search(file_line, search_matches, map_entry_regex)) {
+      debug_map.push_back({stoi(search_matches[1].str()), obj_name,
+                           stoi(search_matches[2].str()),
+                           search_matches[3].str()});
+    } else if(regex_search(file_line, search_matches, merged_entry_regex)) {
+      debug_map.push_back({stoi(search_matches[1].str()),
+                           search_matches[2].str(),
+                           stoi(search_matches[3].str()),
+                           search_matches[4].str()});
+    } else if(file_line != "") {
+      error_code = 3;
+      error_message = "arquivo " + obj_name + ".map corrompido";
+      return;
+    }
+  }
+}
+
 void Modulo::fixCrossReferences(map<string, int> gdt)
 {
   string label;
+  int value;
 
+  // Labels missing from gdt stay external (e.g. in a partial link): their
+  // addresses are still marked, so they aren't relocated as local ones
   for(auto const& item : use_table){
     label = item.first;
     for(auto const& address : item.second) {
-      code[address] += (int) gdt[label];
+      if(gdt.count(label) > 0) {
+        value = code[address] + gdt[label];
+        if(value > 65535) {
+          error_code = 5;
+          error_message = "endereço de " + label + " no módulo " + obj_name + " excede 16 bits";
+          return;
+        }
+        code[address] = value;
+      }
       corrected.push_back(address);
     }
   }
@@ -144,25 +257,57 @@ void Modulo::fixCrossReferences(map<string, int> gdt)
 
 void Modulo::fixRelativeAddresses(int correction)
 {
+  int value;
+
+  // The whole image has to fit in the 16-bit memory, as the loaders expect
+  if(correction + code.size() > 65536) {
+    error_code = 5;
+    error_message = "módulo " + obj_name + " não cabe na memória de 16 bits";
+    return;
+  }
+
   sort(corrected.begin(), corrected.end());
   for (auto const& address : relative) {
     if(!binary_search(corrected.begin(), corrected.end(), address)) {
-      code[address] += (int) correction;
+      value = code[address] + correction;
+      if(value > 65535) {
+        error_code = 5;
+        error_message = "endereço relocado no módulo " + obj_name + " excede 16 bits";
+        return;
+      }
+      code[address] = value;
     }
   }
+  // The debug map follows the module to its place in the executable
+  for (auto& entry : debug_map) {
+    entry.address += correction;
+  }
 }
 
 // Auxiliary methods
 
-vector<int> Modulo::splitStringToInts(string phrase)
+// Turns the distances to the previous address back into addresses, in place
+void Modulo::accumulateDeltas(vector<uint16_t>& addresses)
+{
+  for(size_t i = 1; i < addresses.size(); i++) {
+    addresses[i] += addresses[i - 1];
+  }
+}
+
+// Words written as negative numbers are kept in two's complement. Returns
+// false if something isn't a number or doesn't fit in 16 bits.
+bool Modulo::splitStringToWords(string phrase, vector<uint16_t>& words)
 {
   istringstream line_stream(phrase);
-  vector<string> splitted(istream_iterator<string>{line_stream}, istream_iterator<string>());
-  vector<int> ints;
-  for (auto const &s : splitted) {
-    ints.push_back(stoi(s));
+  int word;
+  words.clear();
+  while(line_stream >> word) {
+    if(word < -32768 || word > 65535) {
+      return false;
+    }
+    words.push_back((uint16_t) word);
   }
-  return ints;
+  return line_stream.eof();
 }
 
 /*
@@ -180,7 +325,7 @@ vector<int> Modulo::splitStringToUChars(string phrase)
 
 // Getters
 
-map<string, vector<int>> Modulo::getUseTable()
+map<string, vector<uint16_t>> Modulo::getUseTable()
 {
   return use_table;
 }
@@ -190,12 +335,12 @@ map<string, int> Modulo::getDefinitionsTable()
   return definitions_table;
 }
 
-vector<int> Modulo::getRelativeAddresses()
+vector<uint16_t> Modulo::getRelativeAddresses()
 {
   return relative;
 }
 
-vector<int> Modulo::getCode()
+vector<uint16_t> Modulo::getCode()
 {
   return code;
 }
@@ -206,6 +351,36 @@ int Modulo::getCodeSize()
   return (int) bytes;
 }
 
+string Modulo::getName()
+{
+  return obj_name;
+}
+
+vector<DebugEntry> Modulo::getDebugMap()
+{
+  return debug_map;
+}
+
+bool Modulo::hasDebugMap()
+{
+  return has_debug_map;
+}
+
+long Modulo::getBytesRead()
+{
+  return bytes_read;
+}
+
+int Modulo::getErrorCode()
+{
+  return error_code;
+}
+
+string Modulo::getErrorMessage()
+{
+  return error_message;
+}
+
 // Debug methods
 
 void Modulo::printAllData()
@@ -248,11 +423,11 @@ void Modulo::printTable(map<string, int> table)
   cout << endl;
 }
 
-void Modulo::printUseTable(map<string, vector<int>> table)
+void Modulo::printUseTable(map<string, vector<uint16_t>> table)
 {
   size_t label_size, max = 5;
   string label;
-  vector<int> addresses;
+  vector<uint16_t> addresses;
   for (auto const &line : table)
   {
     label_size = line.first.length();
@@ -281,7 +456,7 @@ void Modulo::printUseTable(map<string, vector<int>> table)
   cout << endl;
 }
 
-void Modulo::printVectorInt(vector<int> items)
+void Modulo::printVectorInt(vector<uint16_t> items)
 {
   for(auto const& i : items) {
     cout << i << " ";
@@ -0,0 +1,63 @@
+#ifndef ASSEMBLER_HPP_
+#define ASSEMBLER_HPP_
+
+#include <cstdint>
+#include <istream>
+#include <map>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Diagnostics.hpp"
+#include "Stats.hpp"
+
+// Options of an assembly:
+typedef struct {
+  bool optimize = false;          // Peephole optimization (-O).
+  std::ostream *pre = nullptr;    // Pre-processed source (.pre), if any.
+  std::ostream *listing = nullptr; // Listing (.lst), if any.
+  std::ostream *log = nullptr;    // Progress messages ("::..."), if any.
+  Stats *stats = nullptr;         // Time and counters of each pass, if any.
+} AssemblerOptions;
+
+// Entry of the debug map (address -> source line and label):
+typedef struct {
+  unsigned int address;
+  unsigned int line;
+  std::string label;
+} MapEntry;
+
+// Output of an assembly, the module: write_object and write_map turn it
+// into the .obj and .map files. Code words and addresses are 16 bits wide
+// (negative constants in two's complement).
+typedef struct {
+  bool module = false;  // BEGIN and END were given, the .obj has tables.
+  std::map <std::string, std::vector<uint16_t>> use_table;
+  std::map <std::string, int> definitions_table;
+  std::vector <uint16_t> relative, code;
+  std::vector <MapEntry> debug_map;
+} AssemblerOutput;
+
+// Assembles a source held in memory, without touching any file. Errors go
+// to the diagnostics. Returns 0, or the exit code of the montador for the
+// pass that failed (4 pre-processing, 5 first pass, 6 second pass). The
+// pre-processed source goes to options.pre in the background, overlapping
+// the compiling passes, and is complete when this function returns. So does
+// the listing, to options.listing: the address, the words (' marks a
+// relative address, * an external one), the source line number and the
+// original text of each line.
+int assemble(std::string_view source, AssemblerOutput &output,
+             Diagnostics &diagnostics,
+             const AssemblerOptions &options = AssemblerOptions());
+
+// Same, but pipelined: the source is read, formatted and pre-processed by
+// stages on their own threads while the first pass takes the lines that are
+// ready, so it starts before the whole file is read. The output and the
+// errors are the same. With options.optimize it reads the whole source first.
+int assemble(std::istream &source, AssemblerOutput &output,
+             Diagnostics &diagnostics,
+             const AssemblerOptions &options = AssemblerOptions());
+void write_object(std::ostream &, const AssemblerOutput &);
+void write_map(std::ostream &, const AssemblerOutput &);
+
+#endif /* ASSEMBLER_HPP_ */
@@ -0,0 +1,44 @@
+#ifndef DIAGNOSTICS_HPP_
+#define DIAGNOSTICS_HPP_
+
+#include <ostream>
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
+
+typedef enum {
+  NORMAL,
+  FATAL,
+  LEXICAL,
+  SYNTACTIC,
+  SEMANTIC
+} ErrorType;
+
+// Collects the errors of an assembly. Repeated errors are dropped and only
+// the first ones are kept (fatal errors always are); nothing is written
+// until the whole list is written at once, as text or as JSON.
+class Diagnostics
+{
+private:
+  struct Diagnostic {
+    ErrorType type;
+    unsigned int line;
+    std::string code, message;
+  };
+  std::vector<Diagnostic> m_diagnostics;
+  std::set<std::tuple<int, unsigned int, std::string>> m_seen;
+  std::string m_code;
+  size_t m_max, m_dropped;
+public:
+  Diagnostics(size_t t_max = 100);
+  ~Diagnostics();
+  void setCode(std::string t_code);
+  void setMax(size_t t_max);
+  void report(ErrorType t_type, unsigned int t_line, std::string t_message);
+  size_t count();
+  void writeText(std::ostream &t_output);
+  void writeJson(std::ostream &t_output, std::string t_file);
+};
+
+#endif /* DIAGNOSTICS_HPP_ */
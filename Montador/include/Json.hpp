@@ -0,0 +1,40 @@
+#ifndef JSON_HPP_
+#define JSON_HPP_
+
+#include <cstdio>
+#include <string>
+
+// Quotes the text as a JSON string. Quotes, backslashes and control
+// characters (file names and messages may have them) are escaped.
+inline std::string json_quote(const std::string &t_text)
+{
+  std::string quoted = "\"";
+  char escaped[8];
+
+  for(unsigned char character : t_text) {
+
+    if(character == '"' || character == '\\') {
+      quoted += '\\';
+      quoted += character;
+    }
+
+    else if(character == '\n')
+      quoted += "\\n";
+
+    else if(character == '\t')
+      quoted += "\\t";
+
+    else if(character < 0x20) {
+      snprintf(escaped, sizeof(escaped), "\\u%04x", character);
+      quoted += escaped;
+    }
+
+    else
+      quoted += character;
+
+  }
+
+  return quoted + "\"";
+}
+
+#endif /* JSON_HPP_ */
@@ -0,0 +1,84 @@
+#ifndef RINGBUFFER_HPP_
+#define RINGBUFFER_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Bounded queue between exactly one producer thread and one consumer thread,
+// without locks: each side only writes its own index. The producer blocks
+// while the queue is full and the consumer while it is empty. After the last
+// item, the producer closes the queue and pop returns false once it drains.
+template <typename T>
+class RingBuffer
+{
+private:
+  std::vector<T> m_items;
+  std::size_t m_mask;
+  alignas(64) std::atomic<std::size_t> m_head;  // Next item to pop.
+  alignas(64) std::atomic<std::size_t> m_tail;  // Next slot to push.
+  std::atomic<bool> m_closed;
+public:
+  RingBuffer(std::size_t t_capacity);
+  void push(T t_item);
+  bool pop(T &t_item);
+  void close();
+};
+
+// The capacity is rounded up to a power of two.
+template <typename T>
+RingBuffer<T>::RingBuffer(std::size_t t_capacity)
+  : m_head(0), m_tail(0), m_closed(false)
+{
+  std::size_t capacity = 1;
+
+  while(capacity < t_capacity)
+    capacity <<= 1;
+
+  m_items.resize(capacity);
+  m_mask = capacity - 1;
+}
+
+template <typename T>
+void RingBuffer<T>::push(T t_item)
+{
+  std::size_t tail = m_tail.load(std::memory_order_relaxed);
+
+  while(tail - m_head.load(std::memory_order_acquire) == m_items.size())
+    std::this_thread::yield();
+
+  m_items[tail & m_mask] = std::move(t_item);
+  m_tail.store(tail + 1, std::memory_order_release);
+}
+
+template <typename T>
+bool RingBuffer<T>::pop(T &t_item)
+{
+  std::size_t head = m_head.load(std::memory_order_relaxed);
+
+  while(head == m_tail.load(std::memory_order_acquire)) {
+
+    // Closed is only set after the last push, so check the tail again.
+    if(m_closed.load(std::memory_order_acquire) &&
+       head == m_tail.load(std::memory_order_acquire))
+      return false;
+
+    std::this_thread::yield();
+
+  }
+
+  t_item = std::move(m_items[head & m_mask]);
+  m_head.store(head + 1, std::memory_order_release);
+
+  return true;
+}
+
+template <typename T>
+void RingBuffer<T>::close()
+{
+  m_closed.store(true, std::memory_order_release);
+}
+
+#endif /* RINGBUFFER_HPP_ */
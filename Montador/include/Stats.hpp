@@ -0,0 +1,53 @@
+#ifndef STATS_HPP_
+#define STATS_HPP_
+
+#include <chrono>
+#include <ctime>
+#include <map>
+#include <memory_resource>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Per-phase statistics: wall and CPU time, peak resident memory and named
+// counters (lines, symbols, relocations, bytes...). Written as JSON.
+class Stats
+{
+private:
+  struct Phase {
+    std::string name;
+    double wall_ms, cpu_ms;
+    long peak_rss_kb;
+    std::vector<std::pair<std::string, long>> counters;
+  };
+  std::vector<Phase> m_phases;
+  std::chrono::steady_clock::time_point m_wall_start;
+  std::clock_t m_cpu_start;
+  bool m_running;
+public:
+  Stats();
+  ~Stats();
+  void start(std::string t_name);
+  void stop();
+  void count(std::string t_counter, long t_value);
+  void write(std::ostream &t_output, std::string t_tool, std::string t_file);
+};
+
+// Memory resource that forwards to another one and keeps the number of
+// bytes currently allocated and its peak.
+class CountingResource : public std::pmr::memory_resource
+{
+private:
+  std::pmr::memory_resource *m_upstream;
+  long m_allocated, m_peak;
+  void *do_allocate(std::size_t t_bytes, std::size_t t_alignment) override;
+  void do_deallocate(void *t_pointer, std::size_t t_bytes,
+                     std::size_t t_alignment) override;
+  bool do_is_equal(const std::pmr::memory_resource &t_other) const noexcept override;
+public:
+  CountingResource(std::pmr::memory_resource *t_upstream = std::pmr::get_default_resource());
+  long getAllocated();
+  long getPeak();
+};
+
+#endif /* STATS_HPP_ */
@@ -0,0 +1,2062 @@
+// Software básico - Trabalho 02 - Montador (montagem em memória)
+
+// Includes:
+#include <iostream>
+#include <sstream>
+#include <algorithm>
+#include <cstdint>
+#include <regex>
+#include <string>
+#include <map>
+#include <functional>
+#include <future>
+#include <deque>
+#include <thread>
+#include <vector>
+#include <memory_resource>
+#include "Assembler.hpp"
+#include "Operation.hpp"
+#include "RingBuffer.hpp"
+
+#define DEBUG false
+#define PIPELINE_QUEUE_SIZE 1024  // Lines held between pipelined stages.
+
+// Enumerations:
+typedef enum {
+  JUMP,
+  SPACE,
+  CONST,
+  EXTERN
+} LabelType;
+
+typedef enum {
+  BEGIN,
+  TEXT,
+  DATA,
+  BSS,
+  END
+} Section;
+
+// Structs:
+typedef struct {
+  unsigned int text = 0;
+  unsigned int bss = 0;
+  unsigned int data = 0;
+} SectionLines;
+
+// Line of the second pass, parsed and placed in its section and address:
+typedef struct {
+  bool valid = false;
+  unsigned int line = 0;
+  std::string label, operation;
+  std::pmr::vector <std::string> operands;
+  Section section = BEGIN;
+  unsigned int address = 0;
+} ParsedLine;
+
+// Error found by a worker, printed later in the order of the lines:
+typedef struct {
+  size_t index;
+  ErrorType type;
+  unsigned int line;
+  std::string message;
+} PendingError;
+
+// Output of the second pass over a range of lines:
+typedef struct {
+  std::vector <uint16_t> machine_code, relative_addresses;
+  std::vector <MapEntry> debug_map;
+  std::vector <PendingError> errors;
+} PassOutput;
+
+// Namespace:
+using namespace std;
+
+// Function headers:
+int assemble_source(string_view, istream *, AssemblerOutput &, Diagnostics &,
+                    const AssemblerOptions &);
+bool valid_label(string);
+unsigned int peephole_optimize(pmr::vector <pair<unsigned int, string>> &,
+                               unsigned int &);
+pmr::vector <string> split_string(string, string,
+                                pmr::memory_resource * = pmr::get_default_resource());
+string format_line(string);
+void format_lines(pmr::vector <string> &);
+string replace_aliases(string, const pmr::map <string, string> &);
+size_t chunk_count(size_t, size_t);
+void run_in_chunks(size_t, size_t, function <void(size_t, size_t, size_t)>);
+ParsedLine parse_line(const pair <unsigned int, string> &);
+void second_pass(const vector <ParsedLine> &, size_t, size_t,
+                 const pmr::map <string, pair <int, LabelType>> &,
+                 const pmr::map <string, string> &, PassOutput &);
+void format_listing(string &, const vector <ParsedLine> &,
+                    const vector <string_view> &,
+                    const pmr::vector <pair<unsigned int, string>> &,
+                    const pmr::vector <uint16_t> &,
+                    const pmr::vector <uint16_t> &,
+                    const pmr::map <string, pmr::vector<uint16_t>> &);
+
+// Global variables:
+
+// Instruction data: opcode, size and number of operands. Only read after
+// the program starts, so several assemblies can share it.
+map <string, Operation> opcodes_table = {
+  {"ADD", Operation(1,  2, 1)},
+  {"SUB", Operation(2,  2, 1)},
+  {"MULT", Operation(3,  2, 1)},
+  {"DIV", Operation(4,  2, 1)},
+  {"JMP", Operation(5,  2, 1)},
+  {"JMPN", Operation(6,  2, 1)},
+  {"JMPP", Operation(7,  2, 1)},
+  {"JMPZ", Operation(8,  2, 1)},
+  {"COPY", Operation(9,  3, 2)},
+  {"LOAD", Operation(10, 2, 1)},
+  {"STORE", Operation(11, 2, 1)},
+  {"INPUT", Operation(12, 2, 1)},
+  {"OUTPUT", Operation(13, 2, 1)},
+  {"STOP", Operation(14, 1, 0)}
+};
+
+// Assembles the source, see Assembler.hpp.
+int assemble(string_view source, AssemblerOutput &output,
+             Diagnostics &diagnostics, const AssemblerOptions &options) {
+  return assemble_source(source, nullptr, output, diagnostics, options);
+}
+
+// Assembles the source as it is read, see Assembler.hpp.
+int assemble(istream &source, AssemblerOutput &output,
+             Diagnostics &diagnostics, const AssemblerOptions &options) {
+
+  stringstream text;
+
+  // The optimizer needs the whole program before the first pass.
+  if(options.optimize) {
+    text << source.rdbuf();
+    return assemble_source(text.str(), nullptr, output, diagnostics, options);
+  }
+
+  return assemble_source("", &source, output, diagnostics, options);
+}
+
+// Assembles the text, or the stream (pipelined) if there is one.
+int assemble_source(string_view source, istream *stream,
+                    AssemblerOutput &output, Diagnostics &diagnostics,
+                    const AssemblerOptions &options) {
+
+  // The stream is read, pre-processed and assembled at once (see below).
+  bool pipelined = stream != nullptr;
+
+  // Error flags:
+  bool pre_error = false, pass1_error = false, pass2_error = false;
+
+  // Module flags:
+  bool module_start = false, module_end = false, valid_module = false;
+
+  // Progress messages go to the log, or nowhere.
+  ostream log(options.log != nullptr ? options.log->rdbuf() : nullptr);
+
+  // Pre-processed output, written by a background task while the passes
+  // run. The future waits for the task when it goes out of scope, so every
+  // return below also waits for the write (and only after it, the text
+  // goes away).
+  string pre_text;
+  future <void> pre_writer;
+
+  // Listing, written in the background the same way.
+  string listing_text;
+  future <void> listing_writer;
+
+  int offset;
+
+  // Arena for the per-assembly data: all the lists and tables below take
+  // their nodes from it and it is released at once when the program ends.
+  // The counting resource below it measures how much the arena takes.
+  CountingResource arena_usage;
+  pmr::monotonic_buffer_resource arena(&arena_usage);
+
+  // Time and counters of each pass (kept by the caller, if it wants them)
+  Stats local_stats;
+  Stats &stats = options.stats != nullptr ? *options.stats : local_stats;
+  long bytes_read = 0, bytes_written = 0, use_sites = 0;
+
+  // Machine code output
+  pmr::vector <uint16_t> machine_code(&arena), relative_addresses(&arena);
+
+  // Debug map output (which address came from which source line)
+  pmr::vector <MapEntry> debug_map(&arena);
+
+  // Original file lines and buffer to hold the pre-processed ones.
+  pmr::vector <string> file_lines(&arena);
+  pmr::vector <pair<unsigned int, string>> buffer(&arena);
+
+  // Original text of each source line, kept only for the listing. The views
+  // point into the source or, pipelined, into the lines kept by the reader
+  // (on its own thread, so neither takes from the arena).
+  vector <string_view> source_lines;
+  deque <string> streamed_lines;
+
+  // List of operands given in a line:
+  pmr::vector <string> operand_list(&arena);
+
+  // Table for EQU directives (pipelined, it is filled on another thread,
+  // so it can't take from the arena)
+  pmr::map <string, string> aliases_table(pipelined ? pmr::get_default_resource()
+                                                    : &arena);
+
+  // Tables generated in the first pass to be used in the second pass
+  pmr::map <string, pair <int, LabelType>> symbols_table(&arena);
+  pmr::map <string, pmr::vector<uint16_t>> use_table(&arena);
+  pmr::map <string, int> definitions_table(&arena);
+  pmr::map <string, string> constant_table(&arena);
+
+  // Regular expressions (built once, shared by every assembly):
+  static const regex equ_directive("^(.*): EQU(?: (.*))?$");
+  static const regex if_directive("^(.*:)? ?IF(?: (.*))?$");
+  static const regex label_and_offset("^([^\\+]*)(?:\\+([0-9]+))?$");
+  static const regex positive_number("[0-9]+");
+  static const regex section_directive("^(?:(.*): ?)?SECTION(?: (.*))?$");
+  static const regex signed_number("-?[0-9]+");
+  static const regex double_label_regex("^(.*):(.*):.*$");
+  static const regex public_directive("^(.*: )?PUBLIC ([^ ,]+)$");
+  static const regex extern_directive("^(.+): EXTERN$");
+  static const regex label_regex("^(.*): ?([^ ]*)(?: (.*))?$");
+  static const regex command_regex("^([^ :]*)(?: (.*))?$");
+
+  smatch search_matches, search_matches2;  // Search results.
+
+  // Label type indicator
+  LabelType label_type;
+
+  // Section indicator
+  Section actual_section;
+
+  // Section positions
+  SectionLines sections;
+
+  // Strings:
+  string arg_label, argument1;
+  string formated_line, label, operation, operands;
+
+  // Counters
+  unsigned int address, line_num;
+  unsigned int removed_instructions, removed_words;
+
+  // Errors are reported to the caller's diagnostics. While the pipeline
+  // runs, the first pass keeps its errors: they are only reported after the
+  // pre-processing, and only if it was successful (as phase by phase).
+  vector <PendingError> deferred_errors;
+  bool defer_errors = false;
+
+  auto print_error = [&](ErrorType type, int line_num, string message) {
+    if(defer_errors)
+      deferred_errors.push_back({deferred_errors.size(), type,
+                                 (unsigned int) line_num, message});
+    else
+      diagnostics.report(type, line_num, message);
+  };
+
+  // Pipelined stages: the reader, the formatter (format_line) and the
+  // pre-processor run on their own threads and hand the lines down through
+  // these queues. The first pass takes the pre-processed lines on this
+  // thread, as they come. The futures wait for the stages on every return.
+  RingBuffer <string> raw_lines(PIPELINE_QUEUE_SIZE);
+  RingBuffer <string> formatted_lines(PIPELINE_QUEUE_SIZE);
+  RingBuffer <pair<unsigned int, string>> preprocessed_lines(PIPELINE_QUEUE_SIZE);
+  future <void> reader, formatter, preprocessor;
+
+  // Pre-processing pass:
+
+  if(pipelined)
+    log << "::Starting pre-processing and first compiling passes (pipelined)..."
+        << endl << endl;
+  else
+    log << "::Starting pre-processing pass..." << endl << endl;
+
+  stats.start(pipelined ? "pipeline" : "pre-processing");
+  diagnostics.setCode("pre-processing");
+
+  // Source line counter of the pre-processing, apart from the first pass
+  // one since both may run at the same time.
+  unsigned int source_line = 1;
+  bool skip_line = false;
+
+  // Pre-processes a formatted line and gives it to emit, unless it is empty
+  // or a directive. Aliases are replaced in order, since an EQU only applies
+  // to the lines after it. Its errors go straight to the diagnostics.
+  auto preprocess = [&](const string &line, auto emit) {
+
+    string formated_line, label, value, condition;
+    smatch search_matches;
+
+    // Line discarded by an IF directive.
+    if(skip_line) {
+      skip_line = false;
+      source_line++;
+      return;
+    }
+
+    // Replaces EQU directives
+    formated_line = replace_aliases(line, aliases_table);
+
+    // Checks if the line is an EQU directive.
+
+    if(formated_line.find(" EQU") != string::npos &&
+       regex_search(formated_line, search_matches, equ_directive)) {
+
+      label = search_matches[1].str();
+      value = search_matches[2].str();
+
+      if(aliases_table.count(label) > 0)  {
+        diagnostics.report(SEMANTIC, source_line, "A symbol was aliased twice!");
+        pre_error = true;
+      }
+
+      else if(!valid_label(label)) {
+        diagnostics.report(LEXICAL, source_line, "An invalid symbol was aliased!");
+        pre_error = true;
+      }
+
+      // Empty EQU statement.
+
+      else if(value == "") {
+        diagnostics.report(SYNTACTIC, source_line, "An EQU directive needs an alias!");
+        pre_error = true;
+      }
+
+      // The value of an alias should always be a number.
+
+      else if(!regex_match(value, signed_number)) {
+        diagnostics.report(SYNTACTIC, source_line, "An invalid alias was chosen!");
+        pre_error = true;
+      }
+
+      else
+        aliases_table[label] = value;
+
+    }
+
+    // Checks if the line is an IF directive.
+
+    else if(formated_line.find("IF") != string::npos &&
+            regex_search(formated_line, search_matches, if_directive)) {
+
+      label = search_matches[1].str();
+      condition = search_matches[2].str();
+
+      // We might get a label before the IF statement.
+
+      if(label != "") {
+        diagnostics.report(SYNTACTIC, source_line,
+                           "A label was placed before an IF directive!");
+        pre_error = true;
+      }
+
+      // Empty IF statement.
+
+      else if(condition == "") {
+        diagnostics.report(SYNTACTIC, source_line,
+                           "No condition was given to an IF directive!");
+        pre_error = true;
+      }
+
+      else if(condition != "1" && condition != "0") {
+        diagnostics.report(SYNTACTIC, source_line,
+                           "An invalid condition was given to an IF directive!");
+        pre_error = true;
+      }
+
+      else if(condition == "0")
+        skip_line = true;  // Discard the next line;
+
+      // If condition == "1", then we don't need to do anything!
+
+    }
+
+    // Checks if the line is empty or not.
+
+    else if(formated_line != "")
+      emit(make_pair(source_line, formated_line));
+
+    source_line++;
+
+  };
+
+  // Ends the pre-processing pass: writes the .pre output and its counters.
+  // Returns false if there was a pre-processing error.
+  auto end_preprocessing = [&]() {
+
+    // If there was a pre-processing error, stop here.
+    if(pre_error) {
+      print_error(FATAL, 0, "Pre-processing pass was not successful!");
+      return false;
+    }
+
+    // Saves each pre-processed line in the .pre output, if asked. The buffer
+    // may still be changed by the optimizer, so the writer gets its own copy.
+    if(options.pre != nullptr) {
+
+      for(auto const& pair : buffer) {
+        pre_text += pair.second;
+        pre_text += '\n';
+      }
+
+      bytes_written = pre_text.size();
+
+      pre_writer = async(launch::async, [&options, &pre_text]() {
+        *options.pre << pre_text;
+      });
+
+    }
+
+    stats.count("lines", source_line - 1);
+    stats.count("aliases", aliases_table.size());
+    stats.count("bytes_read", bytes_read);
+    stats.count("bytes_written", bytes_written);
+
+    if(!pipelined) {
+      stats.count("arena_bytes", arena_usage.getPeak());
+      stats.stop();
+    }
+
+    log << "::Pre-processing pass was successful!" << endl << endl;
+
+    return true;
+
+  };
+
+  if(pipelined) {
+
+    // Reads the lines, split as in the text below.
+    reader = async(launch::async, [&]() {
+      string line;
+      while(getline(*stream, line)) {
+        bytes_read += line.size() + (stream->eof() ? 0 : 1);
+        if(options.listing != nullptr) {
+          streamed_lines.push_back(line);
+          source_lines.push_back(streamed_lines.back());
+        }
+        raw_lines.push(move(line));
+      }
+      raw_lines.close();
+    });
+
+    // Removes comments and replaces extra spaces.
+    formatter = async(launch::async, [&]() {
+      string line;
+      while(raw_lines.pop(line))
+        formatted_lines.push(format_line(line));
+      formatted_lines.close();
+    });
+
+    preprocessor = async(launch::async, [&]() {
+      string line;
+      while(formatted_lines.pop(line))
+        preprocess(line, [&](pair<unsigned int, string> pre_line) {
+          preprocessed_lines.push(move(pre_line));
+        });
+      preprocessed_lines.close();
+    });
+
+  }
+
+  else {
+
+    // Splits the source in lines first.
+    for(size_t start = 0, end; start < source.size(); start = end + 1) {
+
+      end = source.find('\n', start);
+
+      if(end == string_view::npos)
+        end = source.size();
+
+      file_lines.push_back(string(source.substr(start, end - start)));
+
+      if(options.listing != nullptr)
+        source_lines.push_back(source.substr(start, end - start));
+
+    }
+
+    bytes_read = source.size();
+
+    buffer.reserve(file_lines.size());
+
+    // Removes comments and replaces extra spaces. Each line is independent,
+    // so this (the expensive part) runs in parallel chunks.
+    format_lines(file_lines);
+
+    for(auto const& line : file_lines)
+      preprocess(line, [&buffer](pair<unsigned int, string> pre_line) {
+        buffer.push_back(move(pre_line));
+      });
+
+    if(!end_preprocessing())
+      return 4;
+
+  }
+
+  // Optional peephole optimization. It runs before the first pass, so both
+  // passes assign addresses, relocations and uses to the optimized program.
+  // (Never pipelined, it needs the whole program.)
+  if(options.optimize) {
+
+    stats.start("optimization");
+    diagnostics.setCode("optimization");
+    removed_instructions = peephole_optimize(buffer, removed_words);
+    stats.count("removed_instructions", removed_instructions);
+    stats.count("removed_words", removed_words);
+    stats.stop();
+
+    log << "::Peephole optimization removed " << removed_instructions
+         << " instructions (" << removed_words << " words)!" << endl << endl;
+
+  }
+
+  if(!pipelined)
+    log << "::Starting first compiling pass..." << endl << endl;
+
+  // First pass:
+
+  // TODO Refactor the first pass to utilize the operand_list in address
+  // calculations and to stop checking things that are better left to the
+  // second pass.
+
+  if(pipelined)
+    defer_errors = true;
+
+  else {
+    stats.start("pass1");
+    diagnostics.setCode("pass1");
+  }
+
+  address = 0;  // Reset address counter.
+  actual_section = Section::BEGIN; // Reset section counter.
+
+  // Gives the next pre-processed line to the first pass: pipelined, it is
+  // taken from the queue (and kept in the buffer for the second pass).
+  auto next_line = [&](size_t current) {
+
+    pair<unsigned int, string> pre_line;
+
+    if(current < buffer.size())
+      return true;
+
+    if(!pipelined || !preprocessed_lines.pop(pre_line))
+      return false;
+
+    buffer.push_back(move(pre_line));
+    return true;
+
+  };
+
+  // Iterate over pre-processed file
+  for(size_t current = 0; next_line(current); current++) {
+
+    line_num = buffer[current].first;
+    formated_line = buffer[current].second;
+
+    // Section directive:
+    if(regex_search(formated_line, search_matches, section_directive)) {
+
+      if(DEBUG){
+        cout << line_num << " SECTION" << endl;
+      }
+
+      label = search_matches[1].str();
+      argument1 = search_matches[2].str();
+
+      if(label != "") {
+        print_error(SEMANTIC, line_num,
+                    "SECTION directives cannot have labels!");
+        pass1_error = true;
+      }
+
+      else if(argument1 == "TEXT") {
+
+        // Only one section declaration can exist!
+        if(sections.text != 0) {
+          print_error(SEMANTIC, line_num, "The TEXT section was redeclared!");
+          pass1_error = true;
+        }
+
+        else {
+          sections.text = line_num;
+          actual_section = Section::TEXT;
+        }
+
+      }
+
+      else if(argument1 == "DATA") {
+
+        // The TEXT section has to come first.
+        if(sections.text == 0) {
+          print_error(SEMANTIC, line_num,
+                      "The DATA section was declared before the TEXT section!");
+          pass1_error = true;
+        }
+
+        // Only one section declaration can exist!
+        else if(sections.data != 0) {
+          print_error(SEMANTIC, line_num, "The DATA section was redeclared!");
+          pass1_error = true;
+        }
+
+        else {
+          sections.data = line_num;
+          actual_section = Section::DATA;
+        }
+
+      }
+
+      else if(argument1 == "BSS") {
+
+        // The TEXT section has to come first.
+        if(sections.text == 0) {
+          print_error(SEMANTIC, line_num,
+                      "The BSS section was declared before the TEXT section!");
+          pass1_error = true;
+        }
+
+        // Only one section declaration can exist!
+        else if(sections.bss != 0) {
+          print_error(SEMANTIC, line_num, "The BSS section was redeclared!");
+          pass1_error = true;
+        }
+
+        else {
+          sections.bss = line_num;
+          actual_section = Section::BSS;
+        }
+
+      }
+
+      // Empty section directive.
+
+      else if(argument1 == "") {
+        print_error(SYNTACTIC, line_num, "Empty SECTION directive!");
+        pass1_error = true;
+      }
+
+      // Invalid section argument.
+
+      else {
+        print_error(SYNTACTIC, line_num, "Invalid SECTION directive!");
+        pass1_error = true;
+      }
+
+    } // End Section directive
+    // Tests for double labels
+    else if (regex_search(formated_line, search_matches, double_label_regex)) {
+      if(DEBUG){
+        cout << line_num << " double label" << endl;
+      }
+      print_error(SYNTACTIC, line_num, "You cannot have two labels on the same line!");
+      pass1_error = true;
+    } // End double labels
+    // Public
+    else if(regex_search(formated_line, search_matches, public_directive)) {
+      if(DEBUG){
+        cout << line_num << " PUBLIC" << endl;
+      }
+      label = search_matches[1].str();
+      argument1 = search_matches[2].str();
+      if(label != ""){
+        print_error(SYNTACTIC, line_num, "PUBLIC directives must not have labels!");
+        pass1_error = true;
+      } else if(argument1 == "") {
+        print_error(SYNTACTIC, line_num, "PUBLIC directive must have one argument!");
+        pass1_error = true;
+      } else if(!valid_label(argument1)) {
+        print_error(LEXICAL, line_num, "Argument invalid");
+        pass1_error = true;
+      } else if(definitions_table.count(argument1) > 0) {
+        print_error(SEMANTIC, line_num, "Repeated declaration of label "+argument1+" as PUBLIC");
+        pass1_error = true;
+      } else {
+        definitions_table[argument1] = line_num; // line_num as placeholder for error messages
+      }
+    } // End public
+    // Extern
+    else if(regex_search(formated_line, search_matches, extern_directive)) {
+      if(DEBUG){
+        cout << line_num << " EXTERN" << endl;
+      }
+      label = search_matches[1].str();
+
+      if(label == "") {
+        print_error(SYNTACTIC, line_num, "EXTERN directive must have a label!");
+        pass1_error = true;
+      }
+      else if(symbols_table.count(label) > 0) {
+        print_error(SEMANTIC, line_num, "Label redefined!");
+        pass1_error = true;
+      }
+      else {
+        symbols_table[label] = make_pair(address, LabelType::EXTERN);
+      }
+    } // End extern
+    // Tests for a generic code line with label
+    else if(regex_search(formated_line, search_matches, label_regex)) {
+      if(DEBUG) {
+        cout << line_num << " LABEL" << endl;
+      }
+      label = search_matches[1].str();
+      operation = search_matches[2].str();
+      operands = search_matches[3].str();
+
+      if(operands == "")
+        operand_list.clear();
+
+      else
+        operand_list = split_string(", ", operands, &arena);
+
+      // Adds label to symbols_table if there's one
+      if(label == "") {
+        print_error(SYNTACTIC, line_num, "Empty label!");
+        pass1_error = true;
+      }
+
+      else {
+        if(!valid_label(label)) {
+          print_error(SEMANTIC, line_num, "The label is not valid!");
+          pass1_error = true;
+        }
+        else if (symbols_table.count(label) > 0) {
+          print_error(SEMANTIC, line_num, "Label was redefined!");
+          pass1_error = true;
+        } else {
+
+          if(actual_section == Section::DATA) {
+            label_type = LabelType::CONST;
+            constant_table[label] = argument1;
+          }
+
+          else if(actual_section == Section::BSS)
+            label_type = LabelType::SPACE;
+
+          else
+            label_type = LabelType::JUMP;
+
+
+          symbols_table[label] = make_pair(address, label_type);
+        }
+      }
+
+      // Tests if it's a valid operation
+      if(opcodes_table.count(operation) > 0){
+
+        // Refactor into a function maybe?
+        if(!operand_list.empty()){
+
+          offset = 1; // The first argument has a single offset.
+
+          for (auto const& operand : operand_list) {
+
+            if(regex_search(operand, search_matches2, label_and_offset)) {
+
+              arg_label = search_matches2[1].str();
+
+              if(symbols_table.count(arg_label) > 0) {
+                if(symbols_table[arg_label].second == LabelType::EXTERN)
+                  use_table[arg_label].push_back(address+offset);
+              }
+            }
+
+            offset++;
+
+          }
+
+        }
+
+        address += opcodes_table.at(operation).getSize();
+
+      }
+
+      // If not empty, must be a directive
+      else if((operation == "SPACE" && operand_list.empty()) ||
+              operation == "CONST") {
+        address += 1;
+      }
+
+      else if(operation == "SPACE" && !operand_list.empty()) {
+
+        argument1 = operand_list.front();
+
+        if(regex_match(argument1, positive_number))
+          address += stoi(argument1);
+
+        // But what if the argument for SPACE isn't a positive number?
+        else {
+          print_error(SYNTACTIC, line_num,
+                      "An invalid operand was given to a SPACE directive!");
+          pass1_error = true;
+        }
+
+      }
+
+      else if(operation != "BEGIN" && operation != "END" && operation != "") {
+        print_error(SYNTACTIC, line_num,
+                    "Couldn't find any instruction/directive with that name!");
+        pass1_error = true;
+      }
+
+    } // End code with generic code line with label
+    // Tests for a generic code line without label
+    else if(regex_search(formated_line, search_matches, command_regex)) {
+      if(DEBUG) {
+        cout << line_num << " COMMAND" << endl;
+      }
+      operation = search_matches[1].str();
+      operands = search_matches[2].str();
+
+      if(operands == "")
+        operand_list.clear();
+
+      else
+        operand_list = split_string(", ", operands, &arena);
+
+      // Tests if it's a valid operation
+      if(opcodes_table.count(operation) > 0){
+
+        // Refactor into a function maybe?
+        if(!operand_list.empty()){
+
+          offset = 1; // The first argument has a single offset.
+
+          for (auto const& operand : operand_list) {
+
+            if(regex_search(operand, search_matches2, label_and_offset)) {
+
+              arg_label = search_matches2[1].str();
+
+              if(symbols_table.count(arg_label) > 0) {
+                if(symbols_table[arg_label].second == LabelType::EXTERN)
+                  use_table[arg_label].push_back(address+offset);
+              }
+            }
+
+            offset++;
+
+          }
+
+        }
+
+        address += opcodes_table.at(operation).getSize();
+
+      }
+
+      // If not empty, must be a directive
+      else if((operation == "SPACE" && operand_list.empty()) ||
+              operation == "CONST") {
+        address += 1;
+      }
+
+      else if(operation == "SPACE" && !operand_list.empty()) {
+
+        argument1 = operand_list.front();
+
+        if(regex_match(argument1, positive_number))
+          address += stoi(argument1);
+
+        // But what if the argument for SPACE isn't a positive number?
+        else {
+          print_error(SYNTACTIC, line_num,
+                      "An invalid operand was given to a SPACE directive!");
+          pass1_error = true;
+        }
+
+      }
+
+      else if(operation != "BEGIN" && operation != "END") {
+        print_error(SYNTACTIC, line_num,
+                    "Couldn't find any instruction/directive with that name!");
+        pass1_error = true;
+      }
+
+    } // End code with generic code line without label
+
+    else {
+      if (DEBUG) {
+        cout << line_num << " ELSE" << endl;
+      }
+      print_error(SYNTACTIC, line_num, "Invalid code line!");
+      pass1_error = true;
+    }
+
+  }
+
+  // Pipelined, the pre-processing is only over now. Its errors come first,
+  // then the ones the first pass kept, in their order.
+  if(pipelined) {
+
+    reader.get();
+    formatter.get();
+    preprocessor.get();
+
+    defer_errors = false;
+
+    if(!end_preprocessing())
+      return 4;
+
+    diagnostics.setCode("pass1");
+
+    for(auto const& error : deferred_errors)
+      print_error(error.type, error.line, error.message);
+
+  }
+
+  // Copies symbols values to definitions table
+  for(auto const& iter : definitions_table) {
+    if(symbols_table.count(iter.first) > 0){
+      definitions_table[iter.first] = symbols_table[iter.first].first;
+    } else {
+      print_error(SEMANTIC, iter.second, "Label "+ iter.first +" was never defined!");
+      pass1_error = true;
+    }
+  }
+
+  if(sections.text == 0) {
+    print_error(FATAL, 0, "No TEXT section found!");
+    pass1_error = true;
+  }
+
+  // Code words and addresses are 16 bits wide.
+  if(address > 65536) {
+    print_error(FATAL, 0, "The program doesn't fit in the 16-bit memory!");
+    pass1_error = true;
+  }
+
+  // Prints tables for debug reasons
+  if(DEBUG) {
+
+    cout << endl;
+    cout << " Symbols table:" << endl;
+    cout << " Symbol | address | extern" << endl;
+    for(auto const& iter : symbols_table) {
+      cout << " " << iter.first << " | " << iter.second.first << " | " << iter.second.second << endl;
+    }
+    cout << endl;
+
+    cout << " Definitions table:" << endl;
+    cout << " Symbol | address" << endl;
+    for (auto const& iter : definitions_table)
+    {
+      cout << " " << iter.first << " | " << iter.second << endl;
+    }
+    cout << endl;
+
+    cout << " Use table:" << endl;
+    cout << " Symbol | address " << endl;
+    for (auto const& iter : use_table)
+    {
+      for(auto const& iter2 : iter.second) {
+        cout << " " << iter.first << " | " << iter2 << endl;
+      }
+    }
+    cout << endl;
+  }
+
+  if(pass1_error) {
+    print_error(FATAL, 0, "First compiling pass was not successful!");
+    return 5;
+  }
+
+  // Uses of external labels, as the ligador counts them.
+  for(auto const& extern_label : use_table)
+    use_sites += extern_label.second.size();
+
+  if(!pipelined)
+    stats.count("lines", buffer.size());
+  stats.count("symbols", symbols_table.size());
+  stats.count("definitions", definitions_table.size());
+  stats.count("uses", use_sites);
+  stats.count("words", address);
+  stats.count("arena_bytes", arena_usage.getPeak());
+  stats.stop();
+
+  log << "::First compiling pass was successful!" << endl << endl;
+  log << "::Starting second compiling pass..." << endl << endl;
+
+  // Second pass:
+
+  // The second pass runs in three steps. Each line is parsed in parallel,
+  // then a serial scan follows the SECTION, BEGIN and END directives to learn
+  // the section and the address of each line (the first pass already checked
+  // the sizes), and finally the lines are translated in parallel chunks. The
+  // chunks are merged in order, so the output doesn't depend on the threads.
+
+  stats.start("pass2");
+  diagnostics.setCode("pass2");
+
+  vector <ParsedLine> lines(buffer.size());
+  vector <PendingError> errors;
+  size_t last_line = buffer.size();  // Lines after END aren't translated.
+  size_t chunks;
+
+  chunks = chunk_count(buffer.size(), 1024);
+
+  run_in_chunks(buffer.size(), chunks,
+                [&](size_t chunk, size_t begin, size_t end) {
+    for(size_t i = begin; i < end; i++)
+      lines[i] = parse_line(buffer[i]);
+  });
+
+  address = 0;  // Restart the address counter. It will be needed.
+  actual_section = Section::BEGIN; // Reset the section variable.
+
+  for(size_t i = 0; i < lines.size(); i++) {
+
+    ParsedLine &line = lines[i];
+
+    if(actual_section == Section::END) {
+      errors.push_back({i, SEMANTIC, line.line,
+                  "No commands can be given after the END directive."});
+      last_line = i;
+      break;
+    }
+
+    line.section = actual_section;
+    line.address = address;
+
+    if(!line.valid)
+      continue;
+
+    operation = line.operation;
+    label = line.label;
+
+    if(opcodes_table.count(operation) > 0)
+      address += opcodes_table.at(operation).getSize();
+
+    else if(operation == "SPACE") {
+      if(line.operands.size() == 1
+         && regex_match(line.operands.front(), positive_number))
+        address += stoi(line.operands.front());
+      else
+        address++;
+    }
+
+    else if(operation == "CONST")
+      address++;
+
+    // SECTION directive:
+    else if(operation == "SECTION") {
+
+      // Theoretically speaking, we can assume this SECTION statement is
+      // valid due to the first compiling pass. In practice, a quick check
+      // never hurts!
+
+      if(line.operands.size() != 1) {
+        errors.push_back({i, SYNTACTIC, line.line,
+                    "An invalid number of operands was given!"});
+      }
+
+      else {
+
+        argument1 = line.operands.front();
+
+        if(argument1 == "TEXT")
+          actual_section = Section::TEXT;
+
+        else if(argument1 == "BSS")
+          actual_section = Section::BSS;
+
+        else if(argument1 == "DATA")
+          actual_section = Section::DATA;
+
+        else {
+          errors.push_back({i, SYNTACTIC, line.line,
+                      "An invalid operand was given to a SECTION directive!"});
+        }
+
+      }
+
+    } // End of SECTION directive.
+
+    // BEGIN directive
+    else if(operation == "BEGIN") {
+
+      if(module_start) {
+        errors.push_back({i, SEMANTIC, line.line,
+                    "Only one BEGIN directive can exist!"});
+      }
+
+      else if(label == "") {
+        errors.push_back({i, SYNTACTIC, line.line,
+                    "A BEGIN directive needs to be labeled!"});
+      }
+
+      else if(actual_section != Section::BEGIN) {
+        errors.push_back({i, SEMANTIC, line.line,
+                    "A BEGIN directive cannot come after any command!"});
+      }
+
+      else
+        module_start = true;
+
+    } // End of BEGIN directive.
+
+    // END directive
+    else if(operation == "END") {
+      module_end = true;
+      actual_section = Section::END;
+    }
+
+  }
+
+  // The first pass already knows the size of the program.
+  machine_code.reserve(address);
+  relative_addresses.reserve(address);
+  debug_map.reserve(buffer.size());
+
+  vector <PassOutput> outputs(chunks);
+
+  run_in_chunks(last_line, chunks,
+                [&](size_t chunk, size_t begin, size_t end) {
+    second_pass(lines, begin, end, symbols_table, constant_table,
+                outputs[chunk]);
+  });
+
+  for(auto const& output : outputs) {
+    machine_code.insert(machine_code.end(), output.machine_code.begin(),
+                        output.machine_code.end());
+    relative_addresses.insert(relative_addresses.end(),
+                              output.relative_addresses.begin(),
+                              output.relative_addresses.end());
+    debug_map.insert(debug_map.end(), output.debug_map.begin(),
+                     output.debug_map.end());
+    errors.insert(errors.end(), output.errors.begin(), output.errors.end());
+  }
+
+  // Errors are reported in the order of the lines, like a serial pass would.
+  stable_sort(errors.begin(), errors.end(),
+              [](const PendingError &a, const PendingError &b) {
+                return a.index < b.index;
+              });
+
+  for(auto const& error : errors)
+    print_error(error.type, error.line, error.message);
+
+  pass2_error = !errors.empty();
+
+  valid_module = module_start && module_end;
+
+  // Ok, quick check to see if somebody forgot to BEGIN or END a module!
+  // Remember, either we have both or we have none. Otherwise, it's an error!
+
+  if(module_start != module_end) {
+
+    if(module_start) {
+      print_error(FATAL, 0, "A module needs an END directive!");
+      pass2_error = true;
+    }
+
+    else {
+      print_error(FATAL, 0, "A module needs a BEGIN directive!");
+      pass2_error = true;
+    }
+
+  }
+
+  if(pass2_error) {
+    print_error(FATAL, 0, "Second compiling pass was not successful!");
+    return 6;
+  }
+
+  // The listing comes from the second pass as it is: the lines already know
+  // their addresses and the words are in the machine code. The source text
+  // is the original one (pipelined, once the reader is done with it).
+  if(options.listing != nullptr) {
+
+    if(reader.valid())
+      reader.wait();
+
+    format_listing(listing_text, lines, source_lines, buffer, machine_code,
+                   relative_addresses, use_table);
+
+    listing_writer = async(launch::async, [&options, &listing_text]() {
+      *options.listing << listing_text;
+    });
+
+    stats.count("listing_bytes", listing_text.size());
+
+  }
+
+  stats.count("lines", buffer.size());
+  stats.count("words", machine_code.size());
+  stats.count("relocations", relative_addresses.size());
+  stats.count("arena_bytes", arena_usage.getPeak());
+  stats.stop();
+
+  log << "::Second compiling pass was successful!" << endl << endl;
+
+  // The module goes to the caller in plain containers, the arena's memory
+  // goes away when this function returns.
+  output.module = valid_module;
+
+  for(auto const& extern_label : use_table)
+    output.use_table[extern_label.first].assign(extern_label.second.begin(),
+                                                extern_label.second.end());
+
+  output.definitions_table.insert(definitions_table.begin(),
+                                  definitions_table.end());
+  output.relative.assign(relative_addresses.begin(), relative_addresses.end());
+  output.code.assign(machine_code.begin(), machine_code.end());
+  output.debug_map.assign(debug_map.begin(), debug_map.end());
+
+  return 0;
+
+}
+
+// Writes the module in the .obj format.
+void write_object(ostream &obj_file, const AssemblerOutput &output) {
+
+  string label;
+  int address, previous;
+
+  if(output.module) {
+
+    // TABLE USE:
+    obj_file << "TABLE USE" << "\n";
+
+    for(auto const& extern_label : output.use_table) {
+
+      // The first position of the map contains the label's name.
+      label = extern_label.first;
+
+      obj_file << label;
+
+      // The second position of the map contains the label's use addresses.
+      // They go in a single line: the first one, then the distance from
+      // each one to the previous.
+      previous = 0;
+
+      for(auto const& address : extern_label.second) {
+        obj_file << " " << address - previous;
+        previous = address;
+      }
+
+      obj_file << "\n";
+
+    }
+
+    obj_file << "\n";
+
+    // TABLE DEFINITION:
+    obj_file << "TABLE DEFINITION" << "\n";
+
+    for(auto const& public_label : output.definitions_table) {
+
+      // The first position of the map contains the label's name.
+      label = public_label.first;
+
+      // The second position of the map contains the label's address.
+      address = public_label.second;
+
+      obj_file << label << " " << address << "\n";
+
+    }
+
+    obj_file << "\n";
+
+    // RELATIVE (0 indexed!), the first address and then the distance from
+    // each one to the previous (the addresses are in order, so it's short):
+    obj_file << "RELATIVE DELTA" << "\n";
+
+    previous = 0;
+
+    for(auto iter = output.relative.begin();
+        iter != output.relative.end(); iter++) {
+
+      if(iter != output.relative.begin())
+        obj_file << " ";
+
+      obj_file << *iter - previous;
+      previous = *iter;
+
+      if(iter == prev(output.relative.end()))
+        obj_file << "\n";
+
+    }
+
+    obj_file << "\n";
+
+    // CODE:
+    obj_file << "CODE" << "\n";
+
+  }
+
+  // Relative addresses are written unsigned and the other words (opcodes
+  // and constants) as signed 16-bit numbers, so CONST -5 is still -5.
+  auto relative = output.relative.begin();
+
+  for (size_t i = 0; i < output.code.size(); i++) {
+
+    if (i > 0)
+      obj_file << " ";
+
+    while (relative != output.relative.end() && *relative < i)
+      relative++;
+
+    if (relative != output.relative.end() && *relative == i)
+      obj_file << output.code[i];
+
+    else
+      obj_file << (int16_t) output.code[i];
+
+  }
+
+}
+
+// Writes the debug map (address, source line and label) in the .map format.
+void write_map(ostream &map_file, const AssemblerOutput &output) {
+
+  for(auto const& entry : output.debug_map) {
+
+    map_file << entry.address << " " << entry.line;
+
+    if(entry.label != "")
+      map_file << " " << entry.label;
+
+    map_file << "\n";
+
+  }
+
+}
+
+// Function implementations:
+bool valid_label(string label) {
+
+  bool valid = true;
+  static const regex valid_chars("[a-zA-Z0-9_]+");
+
+  if(label.length() > 50 || !isalpha(label.at(0))
+     || !regex_match(label, valid_chars))
+    valid = false;
+
+  return valid;
+
+}
+
+// Parses a pre-processed line into its label, operation and operands.
+ParsedLine parse_line(const pair <unsigned int, string> &buffer_line) {
+
+  static const regex command("^(?:(.*): ?)?([^ :]*)(?: (.*))?$");
+
+  ParsedLine line;
+  smatch matches;
+
+  line.line = buffer_line.first;
+  line.valid = regex_search(buffer_line.second, matches, command);
+
+  if(line.valid) {
+
+    line.label = matches[1].str();
+    line.operation = matches[2].str();
+
+    if(matches[3].str() != "")
+      line.operands = split_string(", ", matches[3].str());
+
+  }
+
+  return line;
+
+}
+
+// Translates the lines [begin, end) of the second pass. Only reads the tables,
+// so several ranges can run at once, each one with its own output.
+void second_pass(const vector <ParsedLine> &lines, size_t begin, size_t end,
+                 const pmr::map <string, pair <int, LabelType>> &symbols_table,
+                 const pmr::map <string, string> &constant_table,
+                 PassOutput &output) {
+
+  static const regex hex_number("0X[0-9A-F]+");
+  static const regex label_and_offset("^([^\\+]*)(?:\\+([0-9]+))?$");
+  static const regex positive_number("[0-9]+");
+  static const regex signed_number("-?[0-9]+");
+
+  smatch search_matches2;
+  LabelType label_type;
+  string arg_label, argument1, argument2, operation;
+  unsigned int address;
+  int const_value, i, offset;
+
+  for(size_t index = begin; index < end; index++) {
+
+    const ParsedLine &line = lines[index];
+
+    // Theoretically speaking, this should never, EVER be triggered!
+    // Unless you have a line full of spaces or colons.
+    // Did you break my formatting function just to get here?
+    if(!line.valid) {
+      output.errors.push_back({index, SYNTACTIC, line.line, "Invalid command!"});
+      continue;
+    }
+
+    operation = line.operation;
+    address = line.address;  // Address of the first word of this line.
+
+    // Line contains an instruction:
+    if(opcodes_table.count(operation) > 0) {
+
+      output.machine_code.push_back(opcodes_table.at(operation).getOpcode());
+      address++;
+
+      // Invalid section.
+      if(line.section != Section::TEXT) {
+        output.errors.push_back({index, SYNTACTIC, line.line,
+                    "An instruction was used outside the TEXT SECTION!"});
+      }
+
+      // Invalid number of arguments.
+      else if(opcodes_table.at(operation).getNParameters() != line.operands.size()) {
+        output.errors.push_back({index, SYNTACTIC, line.line,
+                    "An invalid number of operands was given!"});
+      }
+
+      // Valid operation.
+      else {
+
+        // Operand analysis.
+        for(auto const& operand : line.operands) {
+
+          if(regex_search(operand, search_matches2, label_and_offset)) {
+
+            arg_label = search_matches2[1].str();
+
+            if(search_matches2[2].str() == "")
+              offset = 0;
+
+            else
+              offset = stoi(search_matches2[2].str());
+
+            // Ok, this next bit of code is a bit tricky.
+            // We first check if the label given as an argument exist.
+            // If it does, we get it's address: symbols_table[label].first.
+            // And add that to the offset given.
+            // The result is stored as machine code.
+            // Finally, we update the machine code address.
+
+            if(symbols_table.count(arg_label) > 0) {
+              if(symbols_table.at(arg_label).first + offset > 65535) {
+                output.errors.push_back({index, SEMANTIC, line.line,
+                            "An operand address exceeds 16 bits!"});
+              }
+              output.machine_code.push_back(symbols_table.at(arg_label).first + offset);
+              output.relative_addresses.push_back(address);
+              address++;
+            }
+
+            else {
+              output.errors.push_back({index, SEMANTIC, line.line,
+                          "A missing label was used as an operand!"});
+            }
+
+          }
+
+          else {
+            output.errors.push_back({index, SYNTACTIC, line.line,
+                        "An invalid operand format was used!"});
+          }
+
+        } // End of operand analysis.
+
+        // Even if the instruction and the operands are valid, there are still
+        // some possible bugs that can occur when you match an instruction
+        // with an operand.
+
+        // Jump instructions cannot be to a different section.
+        if(operation == "JMP" || operation == "JMPN" || operation == "JMPP"
+           || operation == "JMPZ") {
+
+          argument1 = line.operands.front();
+
+          // We already checked for bad/inexistant operands, therefore we do
+          // not need to print any errors if this if statement isn't executed.
+          if(symbols_table.count(argument1) > 0) {
+
+            label_type = symbols_table.at(argument1).second;
+
+            if(label_type == LabelType::CONST ||
+               label_type == LabelType::SPACE) {
+
+              output.errors.push_back({index, SEMANTIC, line.line,
+                          "Jump destination is in another section!"});
+
+            }
+
+          }
+
+        } // End of jump exceptions.
+
+        // Constants cannot be overwritten - Part I.
+        else if(operation == "STORE" || operation == "INPUT") {
+
+          argument1 = line.operands.front();
+
+          // We already checked for bad/inexistant operands, therefore we do
+          // not need to print any errors if this if statement isn't executed.
+          if(symbols_table.count(argument1) > 0) {
+
+            label_type = symbols_table.at(argument1).second;
+
+            if(label_type == LabelType::CONST ||
+               label_type == LabelType::JUMP) {
+
+              output.errors.push_back({index, SEMANTIC, line.line,
+                          "You can only save values to the BSS section!"});
+            }
+
+          }
+
+        } // End of constant exceptions - Part I.
+
+        // Constants cannot be overwritten - Part II.
+        else if(operation == "COPY") {
+
+          argument2 = line.operands.back();
+
+          // We already checked for bad/inexistant operands, therefore we do
+          // not need to print any errors if this if statement isn't executed.
+          if(symbols_table.count(argument2) > 0) {
+
+            label_type = symbols_table.at(argument2).second;
+
+            if(label_type == LabelType::CONST ||
+               label_type == LabelType::JUMP) {
+
+              output.errors.push_back({index, SEMANTIC, line.line,
+                          "You can only save values to the BSS section!"});
+            }
+
+          }
+
+        } // End of constant exceptions - Part II.
+
+        // Program cannot divide by 0.
+        else if(operation == "DIV") {
+
+          argument1 = line.operands.front();
+
+          // We already checked for bad/inexistant operands, therefore we do
+          // not need to print any errors if this if statement isn't executed.
+          if(symbols_table.count(argument1) > 0) {
+
+            label_type = symbols_table.at(argument1).second;
+
+            if(label_type == LabelType::CONST) {
+              if(constant_table.count(argument1) > 0 &&
+                 constant_table.at(argument1) == "0") {
+                output.errors.push_back({index, SEMANTIC, line.line, "You cannot divide by 0!"});
+              }
+            }
+
+          }
+
+        }
+
+      } // End of valid instruction.
+
+    } // End of instruction.
+
+    // If the operation isn't an instruction, them it must be a directive!
+    // SPACE directive:
+    else if(operation == "SPACE") {
+
+      // The SPACE directive needs to be in the BSS SECTION.
+      if(line.section != Section::BSS) {
+        output.errors.push_back({index, SEMANTIC, line.line,
+                    "A SPACE directive was used outside the BSS SECTION!"});
+      }
+
+      // Regular SPACE:
+      else if(line.operands.size() == 0) {
+        output.machine_code.push_back(0);
+        address++;
+      }
+
+      // SPACE with argument:
+      else if(line.operands.size() == 1) {
+
+        argument1 = line.operands.front();
+
+        // Valid operand:
+        if(regex_match(argument1, positive_number)) {
+
+          offset = stoi(argument1);
+
+          if(offset == 0) {
+            output.errors.push_back({index, SYNTACTIC, line.line,
+                        "An invalid operand was given to a SPACE directive!"});
+          }
+
+          else {
+
+            for(i = 0; i < offset; i++)
+              output.machine_code.push_back(0);
+
+            address += offset;
+
+          }
+
+        }
+
+        // Invalid operand:
+        else {
+          output.errors.push_back({index, SYNTACTIC, line.line,
+                      "An invalid operand was given to a SPACE directive!"});
+        }
+
+      } // End of SPACE with argument.
+
+      else {
+        output.errors.push_back({index, SYNTACTIC, line.line,
+                    "An invalid number of operands was given!"});
+      }
+
+    } // End of SPACE.
+
+    // CONST directive.
+    else if(operation == "CONST") {
+
+      // The CONST directive needs to be in the DATA SECTION.
+      if(line.section != Section::DATA) {
+        output.errors.push_back({index, SEMANTIC, line.line,
+                    "A CONST directive was used outside the DATA SECTION!"});
+      }
+
+      // The CONST directive must have an argument:
+      else if(line.operands.size() == 1) {
+
+        argument1 = line.operands.front();
+
+        // Valid decimal operand:
+        if(regex_match(argument1, signed_number)) {
+          const_value = stoi(argument1);
+
+          if(const_value < -32768 || const_value > 32767) {
+            output.errors.push_back({index, SYNTACTIC, line.line,
+                        "A CONST directive operand exceed 16 bits!"});
+          }
+
+          // Negative values are kept in two's complement.
+          else {
+            output.machine_code.push_back((uint16_t) const_value);
+            address++;
+          }
+
+        }
+
+        // Valid hexadecimal number:
+        else if(regex_match(argument1, hex_number)) {
+          const_value = stoul(argument1, nullptr, 16);
+
+          if(const_value > 65535) {
+            output.errors.push_back({index, SYNTACTIC, line.line,
+                        "A CONST directive operand exceed 16 bits!"});
+          }
+
+          else {
+            output.machine_code.push_back(const_value);
+            address++;
+          }
+
+        }
+
+        // Invalid operand:
+        else {
+          output.errors.push_back({index, SYNTACTIC, line.line,
+                      "An invalid operand was given to a CONST directive!"});
+        }
+
+      } // End of CONST with argument.
+
+      else {
+        output.errors.push_back({index, SYNTACTIC, line.line,
+                    "An invalid number of operands was given!"});
+      }
+
+    } // End of CONST directive.
+
+    // Invalid operation (The first processing pass should have caught this):
+    // (SECTION, BEGIN and END were already handled by the serial scan.)
+    else if(operation != "" && operation != "PUBLIC" && operation != "EXTERN"
+            && operation != "SECTION" && operation != "BEGIN"
+            && operation != "END") {
+      output.errors.push_back({index, SYNTACTIC, line.line,
+                  "Couldn't find any instruction/directive with that name!"});
+    }
+
+    // Note: To the second processing pass, the directives "IF" and "EQU"
+    // shouldn't exist and the directives "PUBLIC" and "EXTERN" aren't useful.
+
+    // Lines that generated code or that define a label go to the debug map.
+    // EXTERN labels aren't addresses of this module, so they are skipped.
+    if(operation != "EXTERN" && (address != line.address || line.label != ""))
+      output.debug_map.push_back({line.address, line.line, line.label});
+
+  }
+
+}
+
+// Removes redundant instructions from the pre-processed program:
+//  - "LOAD X" right after "STORE X" (the accumulator already holds X);
+//  - "JMP L" when L labels the next instruction;
+//  - "ADD X" and "SUB X" when X is a CONST 0 of this file.
+// Labels of removed lines are kept as label-only lines, and an instruction
+// that is itself labeled (a possible jump target) is never merged away.
+// Returns the number of removed instructions and sets the removed words.
+unsigned int peephole_optimize(pmr::vector <pair<unsigned int, string>> &buffer,
+                               unsigned int &words) {
+
+  static const regex command("^(?:(.*): ?)?([^ :]*)(?: (.*))?$");
+  static const regex zero("-?0+|0X0+");
+
+  map <string, bool> zero_constants;
+  smatch matches, next_matches;
+  bool changed, in_text;
+  unsigned int removed = 0;
+  string label, operation, operand;
+
+  words = 0;
+
+  // Finds the constants with value 0.
+  for(auto const& pair : buffer) {
+    if(regex_match(pair.second, matches, command) && matches[2] == "CONST"
+       && regex_match(matches[3].str(), zero))
+      zero_constants[matches[1].str()] = true;
+  }
+
+  do {
+
+    changed = false;
+    in_text = false;
+
+    // Removed lines are emptied here and dropped at the end of the round.
+    for(size_t line = 0; line < buffer.size(); line++) {
+
+      if(buffer[line].second == ""
+         || !regex_match(buffer[line].second, matches, command))
+        continue;
+
+      label = matches[1].str();
+      operation = matches[2].str();
+      operand = matches[3].str();
+
+      if(operation == "SECTION") {
+        in_text = (operand == "TEXT");
+        continue;
+      }
+
+      if(!in_text || operand == "")
+        continue;
+
+      size_t next = line + 1;
+      bool remove = false;
+
+      // ADD/SUB of a zero constant.
+      if((operation == "ADD" || operation == "SUB")
+         && zero_constants.count(operand) > 0)
+        remove = true;
+
+      // JMP to the next instruction (possibly past some label-only lines).
+      else if(operation == "JMP") {
+        for(size_t look = next; look < buffer.size(); look++) {
+          if(!regex_match(buffer[look].second, next_matches, command)
+             || next_matches[2] == "SECTION")
+            break;
+          if(next_matches[1] == operand) {
+            remove = true;
+            break;
+          }
+          if(next_matches[2] != "")
+            break;
+        }
+      }
+
+      // LOAD X right after STORE X.
+      else if(operation == "STORE" && next < buffer.size()
+              && regex_match(buffer[next].second, next_matches, command)
+              && next_matches[1] == "" && next_matches[2] == "LOAD"
+              && next_matches[3] == operand) {
+        buffer[next].second = "";
+        removed++;
+        words += 2;
+        changed = true;
+      }
+
+      if(remove) {
+
+        removed++;
+        words += 2;
+        changed = true;
+
+        // An empty label keeps the line (and its address) in place.
+        if(label != "")
+          buffer[line].second = label + ":";
+
+        else
+          buffer[line].second = "";
+
+      }
+
+    }
+
+    buffer.erase(remove_if(buffer.begin(), buffer.end(),
+                           [](pair<unsigned int, string> const& pair) {
+                             return pair.second == "";
+                           }), buffer.end());
+
+  } while(changed);
+
+  return removed;
+
+}
+
+pmr::vector <string> split_string(string delimeter, string input,
+                                  pmr::memory_resource *resource) {
+
+  pmr::vector <string> results(resource);
+  size_t position, start = 0;
+
+  // Lines have few words, and instructions at most two operands.
+  results.reserve(4);
+
+  while((position = input.find(delimeter, start)) != string::npos) {
+    results.push_back(input.substr(start, position - start));
+    start = position + delimeter.size();
+  }
+
+  results.push_back(input.substr(start));
+
+  return results;
+
+}
+
+string format_line(string line) {
+
+  // Compiled only once, on the first call.
+  static const regex colon(":"), comment(";.*"), first_space("^ ");
+  static const regex last_space(" $"), offset_plus1(" \\+"), offset_plus2("\\+ ");
+  static const regex spaces_and_tabs("[ \t]+");
+  string formated_line;
+
+  // Removes comments and extra tabs and spaces.
+
+  formated_line = regex_replace(line, comment, "");
+  formated_line = regex_replace(formated_line, colon, ": ");
+  formated_line = regex_replace(formated_line, spaces_and_tabs, " ");
+  formated_line = regex_replace(formated_line, offset_plus1, "+");
+  formated_line = regex_replace(formated_line, offset_plus2, "+");
+  formated_line = regex_replace(formated_line, first_space, "");
+  formated_line = regex_replace(formated_line, last_space, "");
+
+  // Converts the whole string to uppercase.
+
+  for (auto & c: formated_line)
+    c = toupper(c);
+
+  return formated_line;
+
+}
+
+void format_lines(pmr::vector <string> &lines) {
+
+  // Smaller chunks aren't worth a thread.
+  run_in_chunks(lines.size(), chunk_count(lines.size(), 4096),
+                [&lines](size_t chunk, size_t begin, size_t end) {
+    for(size_t i = begin; i < end; i++)
+      lines[i] = format_line(lines[i]);
+  });
+
+}
+
+// Number of chunks to split the items in: one per core, but never so many
+// that a chunk gets less than min_chunk items.
+size_t chunk_count(size_t items, size_t min_chunk) {
+
+  size_t workers = max(1u, thread::hardware_concurrency());
+
+  return min(workers, items / min_chunk + 1);
+
+}
+
+// Calls function(chunk, begin, end) for each of the chunks of the items,
+// each one on its own thread. The first chunk runs on this thread.
+void run_in_chunks(size_t items, size_t chunks,
+                   function <void(size_t, size_t, size_t)> function) {
+
+  size_t size = (items + chunks - 1) / chunks;
+  vector <thread> threads;
+
+  for(size_t chunk = 1; chunk < chunks; chunk++)
+    threads.push_back(thread(function, chunk, min(items, chunk * size),
+                             min(items, (chunk + 1) * size)));
+
+  function(0, 0, min(items, size));
+
+  for(auto& worker : threads)
+    worker.join();
+
+}
+
+string replace_aliases(string line,
+                       const pmr::map <string, string> &aliases_table) {
+
+  pmr::vector<string> words;
+  size_t next_word = 0;
+  string modded_line = "", word;
+
+  // First, let's get rid of empty lines! Remember: we already formatted the
+  // line, so this corner case catches comments, empty lines, etc...
+
+  if(line == "")
+    return line;
+
+  // Now we split the line along spaces and stores it's words in a list called
+  // words.
+
+  words = split_string(" ", line);
+
+  // Now we have to go through each word and replace any alias with it's value,
+  // being careful to avoid messing with labels and section statements.
+  // Finally, we have to put the whole line back together. Sounds easy, right?
+
+  word = words[next_word++];
+
+  // First let's see if the first word is a label.
+
+  if(word.find(":") != string::npos) {
+
+    // Maybe the line only had a label?
+
+    if(next_word == words.size())
+      return line;
+
+    modded_line.append(word + " ");
+    word = words[next_word++];
+
+  }
+
+  // Ok, now the next word should be an instruction or a directive. We should
+  // not replace those. We might even do a quick check to see if the line is a
+  // SECTION or a BEGIN directive or an instruction without parameters.
+
+  if(word == "SECTION" || word == "BEGIN" || next_word == words.size())
+    return line;
+
+  else
+    modded_line.append(word);
+
+  // Almost there! Now we know that all remaining words are parameters. These
+  // should be checked against the aliases_table.
+
+  do {
+
+    word = words[next_word++];
+
+    // Check to see if the word is in the aliases_table.
+
+    auto alias = aliases_table.find(word);
+
+    if(alias != aliases_table.end())
+      word = alias->second;
+
+    modded_line.append(" " + word);
+
+  } while(next_word < words.size());
+
+  return modded_line;
+
+}
+
+// Formats the listing from the state of the second pass: each line's words
+// go from its address to the next line's, next to the original text of its
+// source line. Long SPACE areas only show their first words and their size.
+void format_listing(string &text, const vector <ParsedLine> &lines,
+                    const vector <string_view> &source_lines,
+                    const pmr::vector <pair<unsigned int, string>> &buffer,
+                    const pmr::vector <uint16_t> &machine_code,
+                    const pmr::vector <uint16_t> &relative_addresses,
+                    const pmr::map <string, pmr::vector<uint16_t>> &use_table) {
+
+  vector <uint16_t> external_addresses;
+  size_t begin, end, shown;
+  string words, number;
+  string_view source_text;
+
+  // Pads the field to the right (text) or to the left (numbers).
+  auto field = [&text](const string &value, size_t width, bool right) {
+    if(right)
+      text.append(width > value.size() ? width - value.size() : 0, ' ');
+    text += value;
+    if(!right)
+      text.append(width > value.size() ? width - value.size() : 0, ' ');
+  };
+
+  for(auto const& extern_label : use_table)
+    external_addresses.insert(external_addresses.end(),
+                              extern_label.second.begin(),
+                              extern_label.second.end());
+
+  sort(external_addresses.begin(), external_addresses.end());
+
+  // Roughly 48 characters per line.
+  text.reserve(text.size() + 48 * lines.size());
+
+  field("addr", 5, true);
+  text += "  ";
+  field("words", 25, false);
+  text += "  ";
+  field("line", 5, true);
+  text += "  source\n";
+
+  for(size_t i = 0; i < lines.size(); i++) {
+
+    begin = lines[i].address;
+    end = i + 1 < lines.size() ? lines[i + 1].address : machine_code.size();
+    shown = end - begin > 4 ? 3 : end - begin;
+
+    words.clear();
+
+    for(size_t address = begin; address < begin + shown; address++) {
+
+      if(!words.empty())
+        words += ' ';
+
+      // Addresses are unsigned and the other words signed, as in the .obj.
+      if(binary_search(external_addresses.begin(), external_addresses.end(),
+                       address))
+        words += to_string(machine_code[address]) + '*';
+
+      else if(binary_search(relative_addresses.begin(),
+                            relative_addresses.end(), address))
+        words += to_string(machine_code[address]) + '\'';
+
+      else
+        words += to_string((int16_t) machine_code[address]);
+
+    }
+
+    if(shown < end - begin)
+      words += " ... (" + to_string(end - begin) + " words)";
+
+    number = to_string(begin);
+    field(number, 5, true);
+    text += "  ";
+    field(words, 25, false);
+    text += "  ";
+    number = to_string(buffer[i].first);
+    field(number, 5, true);
+    text += "  ";
+
+    source_text = buffer[i].first - 1 < source_lines.size() ?
+                  source_lines[buffer[i].first - 1] : string_view();
+
+    if(!source_text.empty() && source_text.back() == '\r')
+      source_text.remove_suffix(1);
+
+    text += source_text;
+    text += '\n';
+
+  }
+
+}
@@ -0,0 +1,114 @@
+#include "Diagnostics.hpp"
+#include <sstream>
+#include "Json.hpp"
+
+Diagnostics::Diagnostics(size_t t_max)
+{
+  m_max = t_max;
+  m_dropped = 0;
+}
+
+Diagnostics::~Diagnostics()
+{
+}
+
+// Code given to the next errors (the pass that finds them).
+void Diagnostics::setCode(std::string t_code)
+{
+  m_code = t_code;
+}
+
+// Maximum number of errors kept (0 keeps all of them).
+void Diagnostics::setMax(size_t t_max)
+{
+  m_max = t_max;
+}
+
+void Diagnostics::report(ErrorType t_type, unsigned int t_line,
+                         std::string t_message)
+{
+  if(!m_seen.insert(std::make_tuple(t_type, t_line, t_message)).second)
+    return;
+
+  if(t_type != FATAL && m_max > 0 && m_diagnostics.size() >= m_max) {
+    m_dropped++;
+    return;
+  }
+
+  m_diagnostics.push_back({t_type, t_line, m_code, t_message});
+}
+
+// Number of different errors reported, kept or not.
+size_t Diagnostics::count()
+{
+  return m_diagnostics.size() + m_dropped;
+}
+
+void Diagnostics::writeText(std::ostream &t_output)
+{
+  std::ostringstream text;
+
+  for(auto const& diagnostic : m_diagnostics) {
+
+    switch (diagnostic.type) {
+
+      case FATAL:
+        text << "[FATAL ERROR]\n";
+        break;
+
+      case LEXICAL:
+        text << "[LEXICAL ERROR] (Line " << diagnostic.line << ")\n";
+        break;
+
+      case SYNTACTIC:
+        text << "[SYNTACTIC ERROR] (Line " << diagnostic.line << ")\n";
+        break;
+
+      case SEMANTIC:
+        text << "[SEMANTIC ERROR] (Line " << diagnostic.line << ")\n";
+        break;
+
+      default:
+        text << "[ERROR]\n";
+
+    }
+
+    text << diagnostic.message << "\n\n";
+
+  }
+
+  if(m_dropped > 0)
+    text << "[NOTE] " << m_dropped << " more errors were not shown!\n\n";
+
+  t_output << text.str();
+}
+
+void Diagnostics::writeJson(std::ostream &t_output, std::string t_file)
+{
+  static const char *type_names[] = {"normal", "fatal", "lexical",
+                                     "syntactic", "semantic"};
+  std::ostringstream json;
+
+  json << "{\n";
+  json << "  \"file\": " << json_quote(t_file) << ",\n";
+  json << "  \"count\": " << count() << ",\n";
+  json << "  \"dropped\": " << m_dropped << ",\n";
+  json << "  \"diagnostics\": [\n";
+
+  for(size_t i = 0; i < m_diagnostics.size(); i++) {
+
+    Diagnostic &diagnostic = m_diagnostics[i];
+
+    json << "    {\"type\": \"" << type_names[diagnostic.type] << "\""
+         << ", \"line\": " << diagnostic.line
+         << ", \"code\": " << json_quote(diagnostic.code)
+         << ", \"message\": " << json_quote(diagnostic.message) << "}"
+         << (i + 1 < m_diagnostics.size() ? "," : "") << "\n";
+
+  }
+
+  json << "  ]\n";
+  json << "}\n";
+
+  t_output << json.str();
+}
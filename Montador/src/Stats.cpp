@@ -0,0 +1,128 @@
+#include "Stats.hpp"
+#include <sys/resource.h>
+#include "Json.hpp"
+
+Stats::Stats()
+{
+  m_running = false;
+}
+
+Stats::~Stats()
+{
+}
+
+void Stats::start(std::string t_name)
+{
+  if(m_running)
+    stop();
+
+  m_phases.push_back({t_name, 0, 0, 0, {}});
+  m_running = true;
+  m_wall_start = std::chrono::steady_clock::now();
+  m_cpu_start = std::clock();
+}
+
+void Stats::stop()
+{
+  struct rusage usage;
+
+  if(!m_running)
+    return;
+
+  Phase &phase = m_phases.back();
+
+  phase.wall_ms = std::chrono::duration<double, std::milli>(
+                    std::chrono::steady_clock::now() - m_wall_start).count();
+  phase.cpu_ms = 1000.0 * (std::clock() - m_cpu_start) / CLOCKS_PER_SEC;
+
+  getrusage(RUSAGE_SELF, &usage);
+  phase.peak_rss_kb = usage.ru_maxrss;
+
+  m_running = false;
+}
+
+// Adds a counter to the current phase (or to the last one, if stopped).
+void Stats::count(std::string t_counter, long t_value)
+{
+  if(m_phases.empty())
+    return;
+
+  m_phases.back().counters.push_back(std::make_pair(t_counter, t_value));
+}
+
+void Stats::write(std::ostream &t_output, std::string t_tool, std::string t_file)
+{
+  double wall_ms = 0, cpu_ms = 0;
+
+  if(m_running)
+    stop();
+
+  t_output << "{\n";
+  t_output << "  \"tool\": " << json_quote(t_tool) << ",\n";
+  t_output << "  \"file\": " << json_quote(t_file) << ",\n";
+  t_output << "  \"phases\": [\n";
+
+  for(size_t i = 0; i < m_phases.size(); i++) {
+
+    Phase &phase = m_phases[i];
+
+    wall_ms += phase.wall_ms;
+    cpu_ms += phase.cpu_ms;
+
+    t_output << "    {\"name\": " << json_quote(phase.name)
+             << ", \"wall_ms\": " << phase.wall_ms
+             << ", \"cpu_ms\": " << phase.cpu_ms
+             << ", \"peak_rss_kb\": " << phase.peak_rss_kb;
+
+    for(auto const& counter : phase.counters)
+      t_output << ", " << json_quote(counter.first) << ": " << counter.second;
+
+    t_output << "}" << (i + 1 < m_phases.size() ? "," : "") << "\n";
+
+  }
+
+  t_output << "  ],\n";
+  t_output << "  \"wall_ms\": " << wall_ms << ",\n";
+  t_output << "  \"cpu_ms\": " << cpu_ms << "\n";
+  t_output << "}\n";
+}
+
+CountingResource::CountingResource(std::pmr::memory_resource *t_upstream)
+{
+  m_upstream = t_upstream;
+  m_allocated = 0;
+  m_peak = 0;
+}
+
+long CountingResource::getAllocated()
+{
+  return m_allocated;
+}
+
+long CountingResource::getPeak()
+{
+  return m_peak;
+}
+
+void *CountingResource::do_allocate(std::size_t t_bytes, std::size_t t_alignment)
+{
+  void *pointer = m_upstream->allocate(t_bytes, t_alignment);
+
+  m_allocated += t_bytes;
+  if(m_allocated > m_peak)
+    m_peak = m_allocated;
+
+  return pointer;
+}
+
+void CountingResource::do_deallocate(void *t_pointer, std::size_t t_bytes,
+                                     std::size_t t_alignment)
+{
+  m_upstream->deallocate(t_pointer, t_bytes, t_alignment);
+  m_allocated -= t_bytes;
+}
+
+bool CountingResource::do_is_equal(const std::pmr::memory_resource &t_other) const noexcept
+{
+  return this == &t_other;
+}
@@ -0,0 +1,9 @@
+LIB_A: BEGIN
+SECTION TEXT
+	N: EXTERN
+	VOLTA: EXTERN
+	PUBLIC DOBRO
+	DOBRO: ADD N
+	STORE N
+	JMP VOLTA
+END
@@ -0,0 +1,11 @@
+LIB_B: BEGIN
+SECTION TEXT
+	N: EXTERN
+	VOLTA: EXTERN
+	PUBLIC DOBRO
+	DOBRO: MULT DOIS
+	STORE N
+	JMP VOLTA
+SECTION DATA
+	DOIS: CONST 2
+END
@@ -0,0 +1,10 @@
+USO_A: BEGIN
+SECTION TEXT
+	DOBRO: EXTERN
+	PUBLIC N
+	INPUT N
+	LOAD N
+	JMP DOBRO
+SECTION BSS
+	N: SPACE
+END
@@ -0,0 +1,16 @@
+USO_B: BEGIN
+SECTION TEXT
+	DOBRO: EXTERN
+	N: EXTERN
+	PUBLIC VOLTA
+	VOLTA: OUTPUT N
+	LOAD N
+	SUB LIMITE
+	JMPP FIM
+	JMPZ FIM
+	LOAD N
+	JMP DOBRO
+	FIM: STOP
+SECTION DATA
+	LIMITE: CONST 100
+END
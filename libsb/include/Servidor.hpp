@@ -0,0 +1,27 @@
+#ifndef SERVIDOR_HPP_
+#define SERVIDOR_HPP_
+
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Server mode of sb: a long-running process listening on a Unix domain
+// socket (local only, readable and writable only by its owner) that runs
+// the requests of thin clients, so each build doesn't start a new process.
+//
+// A request is the number of arguments, the working directory of the
+// client and the arguments, one per line; the client then closes its side.
+// The reply is "status out_size err_size", a new line and the text the
+// request wrote to its output and to its error output.
+
+// Runs each request with the handler, one at a time, from the client's
+// working directory. Only returns if the socket can't be created (1).
+typedef std::function<int(std::vector<std::string>, std::ostream&, std::ostream&)> Handler;
+int serve(std::string socket_name, Handler handler);
+
+// Sends the arguments to the server and writes its reply to cout and cerr.
+// Returns the status of the request, or 1 if the server can't be reached.
+int forward(std::string socket_name, std::vector<std::string> args);
+
+#endif /* SERVIDOR_HPP_ */
@@ -0,0 +1,38 @@
+#ifndef LIBSB_HPP_
+#define LIBSB_HPP_
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Assembler.hpp"
+#include "Diagnostics.hpp"
+
+// libsb: the montador and the ligador as a library. Everything happens in
+// memory (no file is read or written) and errors are returned, the program
+// never exits.
+namespace sb {
+
+// Assembled module (write_object and write_map give its .obj and .map):
+typedef struct {
+  std::string name;           // Module name, used in the linked debug map.
+  AssemblerOutput output;
+  int status;                 // 0, or the exit code of the montador.
+  Diagnostics diagnostics;
+} Object;
+
+// Linked program, the code of its .e file and its merged debug map:
+typedef struct {
+  std::vector<uint16_t> code;
+  std::vector<bool> addresses; // Words that are addresses (unsigned in .e).
+  std::string map;
+  int status;                 // 0, or the exit code of the ligador.
+  std::string error;
+} Image;
+
+Object assemble(std::string_view source, std::string name,
+                const AssemblerOptions &options = AssemblerOptions());
+Image link(const std::vector<Object> &objects);
+
+}
+
+#endif /* LIBSB_HPP_ */
@@ -0,0 +1,216 @@
+#include "Servidor.hpp"
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std;
+
+// Seconds a client has to send its whole request before it is dropped
+#define REQUEST_TIMEOUT 10
+
+// Auxiliary functions
+
+// Fills the address of the socket. Returns false if the name is too long.
+static bool socketAddress(string socket_name, sockaddr_un& address)
+{
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if(socket_name.size() >= sizeof(address.sun_path)) {
+    return false;
+  }
+  strcpy(address.sun_path, socket_name.c_str());
+  return true;
+}
+
+// Tells if a server is already answering on the socket
+static bool serverAlive(const sockaddr_un& address)
+{
+  int connection = socket(AF_UNIX, SOCK_STREAM, 0);
+  bool alive;
+
+  if(connection < 0) {
+    return false;
+  }
+  alive = connect(connection, (sockaddr*) &address, sizeof(address)) == 0;
+  close(connection);
+  return alive;
+}
+
+// Reads until the other side closes its end of the connection (or, with a
+// receive timeout, until it stops sending)
+static bool readAll(int connection, string& data)
+{
+  char buffer[65536];
+  ssize_t count;
+
+  data.clear();
+  while((count = read(connection, buffer, sizeof(buffer))) != 0) {
+    if(count < 0) {
+      return false;
+    }
+    data.append(buffer, count);
+  }
+  return true;
+}
+
+static bool writeAll(int connection, const string& data)
+{
+  size_t written = 0;
+  ssize_t count;
+
+  while(written < data.size()) {
+    count = send(connection, data.data() + written, data.size() - written,
+                 MSG_NOSIGNAL);
+    if(count <= 0) {
+      return false;
+    }
+    written += count;
+  }
+  return true;
+}
+
+// Server
+
+int serve(string socket_name, Handler handler)
+{
+  sockaddr_un address;
+  struct stat socket_stat;
+  timeval timeout = {REQUEST_TIMEOUT, 0};
+  mode_t old_mask;
+  int server, connection, bound;
+  size_t arg_count;
+  string request, directory, arg;
+  vector<string> args;
+  int status;
+
+  if(!socketAddress(socket_name, address)) {
+    cout << "Erro: nome do socket " << socket_name << " é muito longo" << endl;
+    return 1;
+  }
+
+  // A socket left by a server that was stopped is replaced, but not the one
+  // of a server that is still running
+  if(stat(socket_name.c_str(), &socket_stat) == 0 && S_ISSOCK(socket_stat.st_mode)) {
+    if(serverAlive(address)) {
+      cout << "Erro: já existe um servidor em " << socket_name << endl;
+      return 1;
+    }
+    unlink(socket_name.c_str());
+  }
+
+  // Only the user can connect, from the moment the socket is created
+  server = socket(AF_UNIX, SOCK_STREAM, 0);
+  old_mask = umask(077);
+  bound = server < 0 ? -1 : bind(server, (sockaddr*) &address, sizeof(address));
+  umask(old_mask);
+  if(bound != 0 || listen(server, 16) != 0) {
+    cout << "Erro: não é possível criar o socket " << socket_name << endl;
+    return 1;
+  }
+
+  cout << "Servidor esperando pedidos em: " << socket_name << endl;
+
+  while(true) {
+    connection = accept(server, nullptr, nullptr);
+    if(connection < 0) {
+      continue;
+    }
+
+    ostringstream out, err;
+    istringstream request_stream;
+
+    status = 1;
+    args.clear();
+
+    // A client that stops sending doesn't hold the next ones forever
+    setsockopt(connection, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    if(!readAll(connection, request)) {
+      close(connection);
+      continue;
+    }
+    request_stream.str(request);
+
+    if(!(request_stream >> arg_count) || !getline(request_stream, arg) ||
+       !getline(request_stream, directory)) {
+      out << "Erro: pedido inválido" << endl;
+    } else if(chdir(directory.c_str()) != 0) {
+      out << "Erro: pasta " << directory << " não existe!" << endl;
+    } else {
+      while(args.size() < arg_count && getline(request_stream, arg)) {
+        args.push_back(arg);
+      }
+      if(args.size() < arg_count) {
+        out << "Erro: pedido inválido" << endl;
+      } else {
+        status = handler(args, out, err);
+      }
+    }
+
+    writeAll(connection, to_string(status) + " " + to_string(out.str().size()) +
+                         " " + to_string(err.str().size()) + "\n" +
+                         out.str() + err.str());
+    close(connection);
+  }
+}
+
+// Client
+
+int forward(string socket_name, vector<string> args)
+{
+  sockaddr_un address;
+  char directory[4096];
+  string request, reply;
+  size_t header_end, out_size, err_size;
+  int connection, status;
+
+  if(getcwd(directory, sizeof(directory)) == nullptr) {
+    cout << "Erro: pasta atual inválida" << endl;
+    return 1;
+  }
+
+  request = to_string(args.size()) + "\n" + directory + "\n";
+  for(auto const& arg : args) {
+    if(arg.find('\n') != string::npos) {
+      cout << "Erro: argumento inválido" << endl;
+      return 1;
+    }
+    request += arg + "\n";
+  }
+
+  connection = socket(AF_UNIX, SOCK_STREAM, 0);
+  if(!socketAddress(socket_name, address) || connection < 0 ||
+     connect(connection, (sockaddr*) &address, sizeof(address)) != 0) {
+    cout << "Erro: não é possível conectar ao servidor " << socket_name << endl;
+    if(connection >= 0) {
+      close(connection);
+    }
+    return 1;
+  }
+
+  // The server starts once the request is complete
+  if(!writeAll(connection, request) || shutdown(connection, SHUT_WR) != 0 ||
+     !readAll(connection, reply)) {
+    cout << "Erro: o servidor " << socket_name << " não respondeu" << endl;
+    close(connection);
+    return 1;
+  }
+  close(connection);
+
+  header_end = reply.find('\n');
+  if(header_end == string::npos ||
+     sscanf(reply.c_str(), "%d %zu %zu", &status, &out_size, &err_size) != 3 ||
+     reply.size() != header_end + 1 + out_size + err_size) {
+    cout << "Erro: resposta inválida do servidor " << socket_name << endl;
+    return 1;
+  }
+
+  cout << reply.substr(header_end + 1, out_size) << flush;
+  cerr << reply.substr(header_end + 1 + out_size, err_size) << flush;
+  return status;
+}
@@ -0,0 +1,91 @@
+#include "libsb.hpp"
+#include <sstream>
+#include "Linker.hpp"
+#include "Modulo.hpp"
+
+using namespace std;
+
+namespace sb {
+
+// Assembles a source held in memory, like "montador name".
+Object assemble(string_view source, string name,
+                const AssemblerOptions &options)
+{
+  Object object;
+
+  object.name = name;
+  object.status = ::assemble(source, object.output, object.diagnostics,
+                             options);
+
+  return object;
+}
+
+// Links assembled objects in order, like "ligador name1 name2 ...". The first
+// object is placed at address 0. The modules are taken from the assembler's
+// tables, no .obj text is written or parsed.
+Image link(const vector<Object> &objects)
+{
+  Image image;
+  vector<Modulo*> objs;
+  vector<int> correction_table;
+  map<string, int> gdt;
+  vector<DebugEntry> debug_map;
+  ostringstream map_text;
+  bool has_debug_map = false;
+
+  image.status = 0;
+
+  for(auto const& object : objects) {
+
+    if(object.status != 0) {
+      image.status = 3;
+      image.error = "módulo " + object.name + " não foi montado";
+      break;
+    }
+
+    debug_map.clear();
+    for(auto const& entry : object.output.debug_map) {
+      debug_map.push_back({(int) entry.address, object.name, (int) entry.line,
+                           entry.label});
+    }
+    has_debug_map = has_debug_map || !debug_map.empty();
+
+    objs.push_back(new Modulo(object.name, object.output.use_table,
+                              object.output.definitions_table,
+                              object.output.relative, object.output.code,
+                              debug_map));
+
+  }
+
+  if(image.status == 0 && objs.empty()) {
+    image.status = 1;
+    image.error = "Insira no mínimo 1 módulo para ligar";
+  }
+
+  if(image.status == 0) {
+    image.code = linkModules(objs, correction_table, gdt);
+    image.addresses = findAddressWords(objs, correction_table);
+    for(auto const& obj : objs) {
+      if(obj->getErrorCode() != 0) {
+        image.status = obj->getErrorCode();
+        image.error = obj->getErrorMessage();
+        image.code.clear();
+        image.addresses.clear();
+        break;
+      }
+    }
+  }
+
+  if(image.status == 0 && has_debug_map) {
+    writeDebugMap(map_text, objs);
+    image.map = map_text.str();
+  }
+
+  for(auto const& obj : objs) {
+    delete obj;
+  }
+
+  return image;
+}
+
+}
@@ -0,0 +1,264 @@
+// Software básico - Trabalho 02 - Montador e ligador em um só programa
+
+// Includes:
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Imagem.hpp"
+#include "Servidor.hpp"
+#include "libsb.hpp"
+
+// Namespace:
+using namespace std;
+
+// Modules assembled by the server, by the full name of their source. An
+// object is reused while its source and options stay the same.
+typedef struct {
+  string source;
+  bool optimize;
+  sb::Object object;
+} CachedObject;
+
+// Function headers
+int build(vector<string> args, ostream& out, ostream& err,
+          map<string, CachedObject>* cache);
+void assembleAll(vector<string> names, vector<string> sources,
+                 vector<sb::Object>& objects, vector<bool> cached,
+                 AssemblerOptions options, vector<fstream>& pre_files);
+bool writeFile(string name, string contents);
+
+// Main function: builds the program from the arguments, or with --server
+// keeps running and builds the programs its clients (--client) ask for.
+int main(int argc, char const *argv[])
+{
+  vector<string> args(argv + 1, argv + argc);
+  map<string, CachedObject> cache;
+
+  if(args.size() == 2 && args[0] == "--server") {
+    return serve(args[1], [&cache](vector<string> request, ostream& out,
+                                   ostream& err) {
+      return build(request, out, err, &cache);
+    });
+  }
+
+  if(args.size() >= 2 && args[0] == "--client") {
+    return forward(args[1], vector<string>(args.begin() + 2, args.end()));
+  }
+
+  return build(args, cout, cerr, nullptr);
+}
+
+// Assembles the .asm files at once and links them in memory, like
+// "montador" for each file followed by "ligador", but without the
+// intermediate files (written only with --pre and --obj). Messages go to
+// out and the assembler's errors to err. Returns the exit code. With a
+// cache, the sources that didn't change since the last build aren't
+// assembled again.
+int build(vector<string> args, ostream& out, ostream& err,
+          map<string, CachedObject>* cache)
+{
+  vector<string> names, sources, keys;
+  vector<bool> cached;
+  vector<sb::Object> objects;
+  AssemblerOptions options;
+  sb::Image image;
+  string output_name;
+  bool write_pre = false, write_obj = false, compress = false, binary = false;
+  ostringstream obj_text, map_text;
+  fstream asm_file, output_file;
+  vector<fstream> pre_files;
+
+  // Reads options and the names of the files
+  for(size_t i = 0; i < args.size(); i++) {
+    string arg = args[i];
+    if(arg == "-O") {
+      options.optimize = true;
+    } else if(arg == "--pre") {
+      write_pre = true;
+    } else if(arg == "--obj") {
+      write_obj = true;
+    } else if(arg == "--compress") {
+      compress = true;
+    } else if(arg == "--binary") {
+      binary = true;
+    } else if(arg == "-o" && i + 1 < args.size()) {
+      output_name = args[++i];
+    } else if(arg == "" || arg[0] == '-') {
+      out << "Erro: opção desconhecida " << arg << endl;
+      return 1;
+    } else {
+      names.push_back(arg);
+    }
+  }
+
+  if(names.size() < 1) {
+    out << "Erro: Insira no mínimo 1 arquivo para montar e ligar" << endl;
+    out << "Modo de uso: sb [-O] [--pre] [--obj] [--compress | --binary] [-o saida] nome_do_arquivo_sem_asm ..." << endl;
+    out << "             sb --server socket" << endl;
+    out << "             sb --client socket [opções] nome_do_arquivo_sem_asm ..." << endl;
+    return 1;
+  }
+
+  if(output_name == "") {
+    output_name = names[0]; // Same name as the ligador gives
+  }
+
+  // Reads every source first, the assembly itself doesn't touch files
+  for(auto const& name : names) {
+    stringstream source;
+    asm_file.open(name + ".asm", ios::in);
+    if(!asm_file.is_open()) {
+      out << "Erro: arquivo " << name << ".asm não existe!" << endl;
+      return 2;
+    }
+    source << asm_file.rdbuf();
+    asm_file.close();
+    sources.push_back(source.str());
+  }
+
+  // The .pre files are written by the assembly itself, in the background
+  pre_files.resize(write_pre ? names.size() : 0);
+  for(size_t i = 0; i < pre_files.size(); i++) {
+    pre_files[i].open(names[i] + ".pre", ios::out);
+    if(!pre_files[i].is_open()) {
+      out << "Erro: não é possível criar arquivo de saída " << names[i] << ".pre" << endl;
+      return 3;
+    }
+  }
+
+  // Cached objects are taken as they are, unless their .pre is wanted
+  objects.resize(names.size());
+  cached.assign(names.size(), false);
+  for(size_t i = 0; cache != nullptr && i < names.size(); i++) {
+    keys.push_back(filesystem::absolute(names[i] + ".asm").string());
+    if(!write_pre && cache->count(keys[i]) > 0 &&
+       cache->at(keys[i]).source == sources[i] &&
+       cache->at(keys[i]).optimize == options.optimize) {
+      objects[i] = cache->at(keys[i]).object;
+      objects[i].name = names[i];
+      cached[i] = true;
+    }
+  }
+
+  assembleAll(names, sources, objects, cached, options, pre_files);
+
+  for(size_t i = 0; cache != nullptr && i < names.size(); i++) {
+    if(!cached[i]) {
+      (*cache)[keys[i]] = {sources[i], options.optimize, objects[i]};
+    }
+  }
+
+  // Nothing is written when the pre-processing fails
+  for(size_t i = 0; i < pre_files.size(); i++) {
+    pre_files[i].close();
+    if(objects[i].status == 4) {
+      remove((names[i] + ".pre").c_str());
+    }
+  }
+
+  // Errors are shown in the order of the files
+  for(auto& object : objects) {
+    if(object.status != 0) {
+      object.diagnostics.writeText(err);
+      out << "Erro: módulo " << object.name << " não foi montado" << endl;
+      return object.status;
+    }
+    if(write_obj) {
+      obj_text.str("");
+      map_text.str("");
+      write_object(obj_text, object.output);
+      write_map(map_text, object.output);
+      if(!writeFile(object.name + ".obj", obj_text.str()) ||
+         !writeFile(object.name + ".map", map_text.str())) {
+        out << "Erro: não é possível criar arquivo de saída " << object.name << ".obj" << endl;
+        return 3;
+      }
+    }
+  }
+
+  image = sb::link(objects);
+  if(image.status != 0) {
+    out << "Erro: " << image.error << endl;
+    return image.status;
+  }
+
+  output_name += compress ? ".ez" : binary ? ".eb" : ".e";
+
+  output_file.open(output_name, ios::out | ios::binary);
+  if(!output_file.is_open()) {
+    out << "Erro: não é possível criar arquivo de saída " << output_name << endl;
+    return 4;
+  }
+  if(compress) {
+    writeCompressedImage(output_file, image.code);
+  } else if(binary) {
+    writeBinaryImage(output_file, image.code);
+  } else {
+    writeTextImage(output_file, image.code, image.addresses);
+  }
+  output_file.close();
+
+  if(image.map != "" && !writeFile(output_name + ".map", image.map)) {
+    out << "Erro: não é possível criar arquivo de saída " << output_name << ".map" << endl;
+    return 4;
+  }
+
+  out << "Arquivo ligado e salvo em: " << output_name << endl;
+
+  return 0;
+}
+
+// Assembles each source on its own thread (at most one per core), except
+// the cached ones. The objects keep the order of the names. If there are
+// .pre files, each assembly writes its pre-processed source to the one with
+// its index.
+void assembleAll(vector<string> names, vector<string> sources,
+                 vector<sb::Object>& objects, vector<bool> cached,
+                 AssemblerOptions options, vector<fstream>& pre_files)
+{
+  size_t workers = max(1u, thread::hardware_concurrency());
+  atomic<size_t> next(0);
+  vector<thread> threads;
+
+  workers = min(workers, names.size());
+
+  auto work = [&]() {
+    AssemblerOptions file_options = options;
+    for(size_t i = next++; i < names.size(); i = next++) {
+      if(cached[i]) {
+        continue;
+      }
+      file_options.pre = i < pre_files.size() ? &pre_files[i] : nullptr;
+      objects[i] = sb::assemble(sources[i], names[i], file_options);
+    }
+  };
+
+  for(size_t i = 1; i < workers; i++) {
+    threads.push_back(thread(work));
+  }
+  work();
+  for(auto& worker : threads) {
+    worker.join();
+  }
+}
+
+// Writes the contents to a new file. Returns false if it can't be created.
+bool writeFile(string name, string contents)
+{
+  fstream file;
+
+  file.open(name, ios::out);
+  if(!file.is_open()) {
+    return false;
+  }
+  file << contents;
+  file.close();
+  return true;
+}